@@ -33,6 +33,9 @@ try:
     sources.remove(ffish_source_file)
 except ValueError:
     print(f"ffish_source_file {ffish_source_file} was not found in sources {sources}.")
+capi_source_file = os.path.normcase("src/fairystockfish.cpp")
+if capi_source_file in sources:
+    sources.remove(capi_source_file)
 
 pyffish_module = Extension(
     "pyffish",
@@ -285,38 +285,7 @@ const std::string move_to_san(Position& pos, Move m, Notation n) {
 }
 
 bool hasInsufficientMaterial(Color c, const Position& pos) {
-
-    // Other win rules
-    if (   pos.captures_to_hand()
-           || pos.count_in_hand(c, ALL_PIECES)
-           || pos.extinction_value() != VALUE_NONE
-           || (pos.capture_the_flag_piece() && pos.count(c, pos.capture_the_flag_piece())))
-        return false;
-
-    // Restricted pieces
-    Bitboard restricted = pos.pieces(~c, KING);
-    for (PieceType pt : pos.piece_types())
-        if (pt == KING || !(pos.board_bb(c, pt) & pos.board_bb(~c, KING)))
-            restricted |= pos.pieces(c, pt);
-
-    // Mating pieces
-    for (PieceType pt : { ROOK, QUEEN, ARCHBISHOP, CHANCELLOR, SILVER, GOLD, COMMONER, CENTAUR })
-        if ((pos.pieces(c, pt) & ~restricted) || (pos.count(c, PAWN) && pos.promotion_piece_types().find(pt) != pos.promotion_piece_types().end()))
-            return false;
-
-    // Color-bound pieces
-    Bitboard colorbound = 0, unbound;
-    for (PieceType pt : { BISHOP, FERS, FERS_ALFIL, ALFIL, ELEPHANT })
-        colorbound |= pos.pieces(pt) & ~restricted;
-    unbound = pos.pieces() ^ restricted ^ colorbound;
-    if ((colorbound & pos.pieces(c)) && (((DarkSquares & colorbound) && (~DarkSquares & colorbound)) || unbound))
-        return false;
-
-    // Unbound pieces require one helper piece of either color
-    if ((pos.pieces(c) & unbound) && (popcount(pos.pieces() ^ restricted) >= 2 || pos.stalemate_value() != VALUE_DRAW))
-        return false;
-
-    return true;
+    return pos.has_insufficient_material(c);
 }
 
 namespace fen {
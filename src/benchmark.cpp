@@ -16,13 +16,21 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <istream>
+#include <sstream>
 #include <vector>
 
+#include "movegen.h"
 #include "position.h"
+#include "thread.h"
 #include "uci.h"
+#include "variant.h"
 
 using namespace std;
 
@@ -91,19 +99,133 @@ const vector<string> Defaults = {
   "setoption name UCI_Chess960 value false"
 };
 
+// Tsume shogi problems with the number of moves of the shortest mate, used by
+// mate_bench(). Every mate is by checks only and has been verified by both the
+// proof-number and the alpha-beta search. The problems of six moves or more
+// show how the searches scale with the length of the mate.
+const vector<pair<string, int>> TsumeProblems = {
+  { "3psk+P2/9/3r5/3+B5/9/9/9/9/9 b GS 1", 1 },
+  { "6b2/5kl2/5n1r1/6+P2/3R2B2/9/9/9/9 b GS 1", 2 },
+  { "5R1k1/7l1/5brp1/9/6+R1B/9/9/9/9 b S 1", 3 },
+  { "p1k+R5/4L4/1l7/3+P5/9/9/9/9/9 b S 1", 3 },
+  { "4l4/4k4/3b5/6+R2/9/3+B5/9/9/9 b BSP 1", 3 },
+  { "s1r6/k1n6/9/9/NS7/2B6/9/9/9 b RGS 1", 3 },
+  { "ks7/p1r6/1G7/2L6/R8/9/9/9/9 b BG 1", 3 },
+  { "3sk1r2/9/9/6L2/6+B2/9/9/9/9 b GSP 1", 4 },
+  { "1p7/bk7/2L6/1B7/+B8/9/9/9/9 b N 1", 4 },
+  { "r8/k1g6/9/2P6/1+P+R6/9/9/9/9 b RS 1", 4 },
+  { "3+b1g1k1/L3g4/bR2n4/9/9/9/9/9/9 b RGN 1", 6 },
+  { "3k2n2/7+B1/S2rps3/9/9/9/9/9/9 b RBP 1", 6 },
+  { "1r5l1/k3n2+B1/4s1+b2/3+R5/9/9/9/9/9 b SNL 1", 6 },
+  { "2k1+B1G1+p/6+p2/9/9/9/9/9/9/9 b SSL 1", 7 },
+  { "3pk1+P2/7g1/9/2gP4R/9/9/9/9/9 b RN 1", 8 },
+  { "2R4g1/l3k3S/9/9/9/9/9/9/9 b R 1", 8 },
+  { "1s5k1/3r5/6+p1R/4N1G2/9/9/9/9/9 b G 1", 8 },
+  { "1+B6k/4s4/p1Sg4r/9/9/9/9/9/9 b RG 1", 9 }
+};
+
+// Number of positions searched by multipv_bench()
+constexpr int MultiPVPositions = 8;
+
+// Positions of one variant with their moves, used by movegen_bench()
+struct BenchPosition {
+  Position pos;
+  StateInfo st;
+  vector<Move> pseudoLegal, legal;
+  vector<bool> givesCheck;
+};
+
+volatile uint64_t Sink; // Keeps the benchmarked calls from being optimized away
+
+// Collect positions of a variant by random playouts from the start position
+void collect_positions(const Variant* v, deque<BenchPosition>& positions) {
+
+  constexpr int Games = 8, MaxPly = 60, Interval = 3;
+  PRNG rng(1070372);
+
+  for (int g = 0; g < Games; ++g)
+  {
+      StateListPtr states(new deque<StateInfo>(1));
+      Position pos;
+      pos.set(v, v->startFen, false, &states->back(), Threads.main());
+
+      for (int ply = 0; ply < MaxPly; ++ply)
+      {
+          MoveList<LEGAL> moves(pos);
+          Value result;
+          if (!moves.size() || pos.is_game_end(result))
+              break;
+
+          if (ply % Interval == 0)
+          {
+              positions.emplace_back();
+              BenchPosition& bp = positions.back();
+              bp.pos.set(v, pos.fen(), false, &bp.st, Threads.main());
+
+              ExtMove list[MAX_MOVES];
+              ExtMove* last = bp.pos.checkers() ? generate<EVASIONS>(bp.pos, list)
+                                                : generate<NON_EVASIONS>(bp.pos, list);
+              for (ExtMove* m = list; m < last; ++m)
+                  bp.pseudoLegal.push_back(*m);
+              for (const auto& m : MoveList<LEGAL>(bp.pos))
+              {
+                  bp.legal.push_back(m);
+                  bp.givesCheck.push_back(bp.pos.gives_check(m));
+              }
+          }
+
+          states->emplace_back();
+          pos.do_move(moves.begin()[rng.rand<unsigned>() % moves.size()], states->back());
+      }
+  }
+}
+
+// Run a pass over all positions the given number of times and return
+// the nanoseconds per call. The pass returns the number of calls made.
+template<typename F>
+double ns_per_call(int reps, F pass) {
+
+  uint64_t calls = 0;
+  auto start = chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r)
+      calls += pass();
+  chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+  return calls ? elapsed.count() / calls : 0;
+}
+
+template<GenType Type>
+double time_generate(deque<BenchPosition>& positions, int reps, bool inCheck) {
+
+  return ns_per_call(reps, [&]() {
+      uint64_t calls = 0, sum = 0;
+      ExtMove list[MAX_MOVES];
+      for (auto& bp : positions)
+          if (bool(bp.pos.checkers()) == inCheck)
+          {
+              sum += generate<Type>(bp.pos, list) - list;
+              ++calls;
+          }
+      Sink = sum;
+      return calls;
+  });
+}
+
 } // namespace
 
 /// setup_bench() builds a list of UCI commands to be run by bench. There
 /// are five parameters: TT size in MB, number of search threads that
 /// should be used, the limit value spent for each position, a file name
 /// where to look for positions in FEN format, the type of the limit:
-/// depth, perft, nodes and movetime (in millisecs), and evaluation type
+/// depth, perft, nodes, threadnodes (nodes per thread) and movetime (in
+/// millisecs), and evaluation type
 /// mixed (default), classical, NNUE.
 ///
 /// bench -> search default positions up to depth 13
 /// bench 64 1 15 -> search default positions up to depth 15 (TT = 64MB)
 /// bench 64 4 5000 current movetime -> search current position with 4 threads for 5 sec
 /// bench 64 1 100000 default nodes -> search default positions for 100K nodes each
+/// bench 64 4 100000 default threadnodes -> each of 4 threads searches 100K nodes per position
 /// bench 16 1 5 default perft -> run a perft 5 on default positions
 
 vector<string> setup_bench(const Position& current, istream& is) {
@@ -189,3 +311,270 @@ vector<string> setup_bench(const Position& current, istream& is) {
 
   return list;
 }
+
+
+/// movegen_bench() times move generation and make/unmake in isolation from
+/// search and evaluation. For each variant it collects positions by random
+/// playouts and reports nanoseconds per call of each function. The optional
+/// parameters are a variant name (default all variants) and the number of
+/// passes over the positions.
+///
+/// bench movegen -> all variants, 20 passes
+/// bench movegen 50 -> all variants, 50 passes
+/// bench movegen crazyhouse 200 -> crazyhouse only, 200 passes
+
+void movegen_bench(istream& is) {
+
+  string token;
+  int reps = 20;
+  vector<string> names = variants.get_keys();
+
+  streampos args = is.tellg();
+  // Check whether the next token is a variant name or already the pass count
+  if (is >> token)
+  {
+      if (variants.find(token) != variants.end())
+          names = { token };
+      else if (!token.empty() && token.find_first_not_of("0123456789") == string::npos)
+          is.seekg(args);
+      else if (token != "all")
+      {
+          cerr << "Unknown variant " << token << endl;
+          return;
+      }
+  }
+  is >> reps;
+
+  cerr << "ns per call" << left << setw(22) << ""
+       << right << setw(6) << "pos"
+       << setw(9) << "legalgen" << setw(9) << "captures" << setw(9) << "quiets" << setw(9) << "evasions"
+       << setw(9) << "legal" << setw(9) << "check" << setw(9) << "see_ge" << setw(9) << "do/undo" << endl;
+
+  for (const string& name : names)
+  {
+      deque<BenchPosition> positions;
+      collect_positions(variants.find(name)->second, positions);
+
+      size_t inCheck = count_if(positions.begin(), positions.end(),
+                                [](const BenchPosition& bp) { return bool(bp.pos.checkers()); });
+
+      double legalGen = ns_per_call(reps, [&]() {
+          uint64_t sum = 0;
+          for (auto& bp : positions)
+              sum += MoveList<LEGAL>(bp.pos).size();
+          Sink = sum;
+          return positions.size();
+      });
+
+      double captures = time_generate<CAPTURES>(positions, reps, false);
+      double quiets   = time_generate<QUIETS>(positions, reps, false);
+      double evasions = time_generate<EVASIONS>(positions, reps, true);
+
+      double legal = ns_per_call(reps, [&]() {
+          uint64_t calls = 0, sum = 0;
+          for (auto& bp : positions)
+              for (Move m : bp.pseudoLegal)
+                  sum += bp.pos.legal(m), ++calls;
+          Sink = sum;
+          return calls;
+      });
+
+      double givesCheck = ns_per_call(reps, [&]() {
+          uint64_t calls = 0, sum = 0;
+          for (auto& bp : positions)
+              for (Move m : bp.legal)
+                  sum += bp.pos.gives_check(m), ++calls;
+          Sink = sum;
+          return calls;
+      });
+
+      double see = ns_per_call(reps, [&]() {
+          uint64_t calls = 0, sum = 0;
+          for (auto& bp : positions)
+              for (Move m : bp.legal)
+                  sum += bp.pos.see_ge(m), ++calls;
+          Sink = sum;
+          return calls;
+      });
+
+      double doUndo = ns_per_call(reps, [&]() {
+          uint64_t calls = 0;
+          StateInfo st;
+          for (auto& bp : positions)
+              for (size_t i = 0; i < bp.legal.size(); ++i)
+              {
+                  bp.pos.do_move(bp.legal[i], st, bp.givesCheck[i]);
+                  bp.pos.undo_move(bp.legal[i]);
+                  ++calls;
+              }
+          return calls;
+      });
+
+      auto field = [](double ns, bool valid = true) {
+          ostringstream ss;
+          if (valid)
+              ss << fixed << setprecision(1) << ns;
+          else
+              ss << "-";
+          return ss.str();
+      };
+
+      cerr << left << setw(33) << name << right << setw(6) << positions.size()
+           << setw(9) << field(legalGen)
+           << setw(9) << field(captures, inCheck < positions.size())
+           << setw(9) << field(quiets, inCheck < positions.size())
+           << setw(9) << field(evasions, inCheck > 0)
+           << setw(9) << field(legal) << setw(9) << field(givesCheck)
+           << setw(9) << field(see) << setw(9) << field(doUndo) << endl;
+  }
+}
+
+
+/// mate_bench() compares the proof-number mate solver with the alpha-beta
+/// search on tsume shogi problems. Each problem is searched with "go mate" in
+/// tsume mode, once with each search, and the time and nodes are reported.
+/// The optional parameter is the time limit per search in milliseconds.
+///
+/// bench mate -> 10 seconds per search
+/// bench mate 1000 -> 1 second per search
+
+void mate_bench(istream& is) {
+
+  TimePoint movetime = 10000;
+  is >> movetime;
+
+  auto shogi = variants.find("shogi");
+  if (shogi == variants.end())
+  {
+      cerr << "bench mate requires a build with largeboards=yes" << endl;
+      return;
+  }
+
+  const bool tsumeMode = Options["TsumeMode"], mateSolver = Options["MateSolver"];
+  Options["TsumeMode"] = string("true");
+
+  // Runs the search and returns the mate score in moves, 0 if none was found
+  auto solve = [&](const string& sfen, int mate, bool dfpn, TimePoint& elapsed, uint64_t& nodes) {
+      Options["MateSolver"] = string(dfpn ? "true" : "false");
+
+      StateListPtr states(new deque<StateInfo>(1));
+      Position pos;
+      pos.set(shogi->second, sfen, false, &states->back(), Threads.main(), true);
+
+      Search::LimitsType limits;
+      limits.mate = mate;
+      limits.movetime = movetime;
+
+      Search::clear();
+      limits.startTime = now();
+      Threads.start_thinking(pos, states, limits);
+      Threads.main()->wait_for_search_finished();
+
+      elapsed = now() - limits.startTime;
+      nodes = Threads.nodes_searched();
+      Value v = Threads.main()->rootMoves[0].score;
+      return v >= VALUE_MATE_IN_MAX_PLY ? (VALUE_MATE - v + 1) / 2 : 0;
+  };
+
+  TimePoint total[2] = {};
+  int solved[2] = {};
+  vector<string> lines;
+
+  for (const auto& problem : TsumeProblems)
+  {
+      ostringstream ss;
+      ss << left << setw(45) << problem.first << right << setw(5) << problem.second;
+
+      for (bool dfpn : { true, false })
+      {
+          TimePoint elapsed;
+          uint64_t nodes;
+          int found = solve(problem.first, problem.second, dfpn, elapsed, nodes);
+
+          total[dfpn] += elapsed;
+          solved[dfpn] += found == problem.second;
+          ss << setw(8) << (found ? to_string(found) : "-") << setw(8) << elapsed << setw(12) << nodes;
+      }
+      lines.push_back(ss.str());
+  }
+
+  Options["TsumeMode"] = string(tsumeMode ? "true" : "false");
+  Options["MateSolver"] = string(mateSolver ? "true" : "false");
+
+  cerr << "\n" << left << setw(45) << "Position" << right << setw(5) << "mate"
+       << setw(8) << "df-pn" << setw(8) << "ms" << setw(12) << "nodes"
+       << setw(8) << "ab" << setw(8) << "ms" << setw(12) << "nodes" << endl;
+  for (const string& line : lines)
+      cerr << line << endl;
+  cerr << left << setw(50) << "Solved / total time (ms)" << right
+       << setw(8) << solved[1] << setw(8) << total[1] << setw(12) << ""
+       << setw(8) << solved[0] << setw(8) << total[0] << endl;
+}
+
+
+/// multipv_bench() measures the time to depth of MultiPV searches at different
+/// numbers of threads, on the first chess positions of the default bench. The
+/// optional parameters are the depth, the number of PV lines and the thread
+/// counts. The hash table is cleared before every search.
+///
+/// bench multipv -> depth 13, 8 lines, with 1, 4 and 16 threads
+/// bench multipv 16 5 1 2 4 8 -> depth 16, 5 lines, with 1, 2, 4 and 8 threads
+
+void multipv_bench(istream& is) {
+
+  Depth depth = 13;
+  size_t multiPV = 8;
+  vector<size_t> threads;
+  is >> depth >> multiPV;
+  for (size_t n; is >> n; )
+      threads.push_back(n);
+  if (threads.empty())
+      threads = { 1, 4, 16 };
+
+  const string threadsOption = Options["Threads"], multiPVOption = Options["MultiPV"];
+  Options["MultiPV"] = to_string(multiPV);
+
+  cerr << "\n" << setw(8) << "Threads" << setw(12) << "ms" << setw(14) << "nodes"
+       << setw(10) << "speedup" << endl;
+
+  TimePoint base = 0;
+  for (size_t n : threads)
+  {
+      Options["Threads"] = to_string(n);
+      TimePoint elapsed = 0;
+      uint64_t nodes = 0;
+
+      int count = 0;
+      for (const string& fen : Defaults)
+      {
+          // The first standard chess positions
+          if (fen.find("setoption") == 0 || fen.find("moves") != string::npos)
+              continue;
+          if (++count > MultiPVPositions)
+              break;
+
+          StateListPtr states(new deque<StateInfo>(1));
+          Position pos;
+          pos.set(variants.find("chess")->second, fen, false, &states->back(), Threads.main());
+
+          Search::LimitsType limits;
+          limits.depth = depth;
+
+          Search::clear();
+          limits.startTime = now();
+          Threads.start_thinking(pos, states, limits);
+          Threads.main()->wait_for_search_finished();
+
+          elapsed += now() - limits.startTime;
+          nodes += Threads.nodes_searched();
+      }
+
+      if (!base)
+          base = std::max(elapsed, TimePoint(1));
+      cerr << setw(8) << n << setw(12) << elapsed << setw(14) << nodes
+           << setw(10) << fixed << setprecision(2) << double(base) / std::max(elapsed, TimePoint(1)) << endl;
+  }
+
+  Options["Threads"] = threadsOption;
+  Options["MultiPV"] = multiPVOption;
+}
@@ -344,7 +344,7 @@ namespace {
 #endif
 
     // Optimal PRNG seeds to pick the correct magics in the shortest time
-#ifndef PRECOMPUTED_MAGICS
+#if !defined(PRECOMPUTED_MAGICS) && !defined(USE_PEXT)
 #ifdef LARGEBOARDS
     int seeds[][RANK_NB] = { { 734, 10316, 55013, 32803, 12281, 15100,  16645, 255, 346, 89123 },
                              { 734, 10316, 55013, 32803, 12281, 15100,  16645, 255, 346, 89123 } };
@@ -354,12 +354,15 @@ namespace {
 #endif
 #endif
 
+    Bitboard edges, b;
+    int size = 0;
+
+#ifndef USE_PEXT
     Bitboard* occupancy = new Bitboard[1 << (FILE_NB + RANK_NB - 4)];
     Bitboard* reference = new Bitboard[1 << (FILE_NB + RANK_NB - 4)];
-    Bitboard edges, b;
     int* epoch = new int[1 << (FILE_NB + RANK_NB - 4)]();
-    int cnt = 0, size = 0;
-
+    int cnt = 0;
+#endif
 
     for (Square s = SQ_A1; s <= SQ_MAX; ++s)
     {
@@ -373,33 +376,41 @@ namespace {
         // apply to the 64 or 32 bits word to get the index.
         Magic& m = magics[s];
         m.mask  = (MT == LAME_LEAPER ? lame_leaper_path(directions, s) : sliding_attack<MT == HOPPER ? RIDER : MT>(directions, s, 0)) & ~edges;
+
+        // Set the offset for the attacks table of the square. We have individual
+        // table sizes for each square with "Fancy Magic Bitboards".
+        m.attacks = s == SQ_A1 ? table : magics[s - 1].attacks + size;
+
+#ifdef USE_PEXT
+#ifdef LARGEBOARDS
+        m.lowBits = popcount((m.mask << 64) >> 64);
+#endif
+
+        // With pext the index of each subset of the mask is known up front,
+        // so the attacks are stored directly without searching for a magic.
+        b = size = 0;
+        do {
+            m.attacks[m.index(b)] = MT == LAME_LEAPER ? lame_leaper_attack(directions, s, b) : sliding_attack<MT>(directions, s, b);
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+#else
 #ifdef LARGEBOARDS
         m.shift = 128 - popcount(m.mask);
 #else
         m.shift = (Is64Bit ? 64 : 32) - popcount(m.mask);
 #endif
 
-        // Set the offset for the attacks table of the square. We have individual
-        // table sizes for each square with "Fancy Magic Bitboards".
-        m.attacks = s == SQ_A1 ? table : magics[s - 1].attacks + size;
-
         // Use Carry-Rippler trick to enumerate all subsets of masks[s] and
         // store the corresponding sliding attack bitboard in reference[].
         b = size = 0;
         do {
             occupancy[size] = b;
             reference[size] = MT == LAME_LEAPER ? lame_leaper_attack(directions, s, b) : sliding_attack<MT>(directions, s, b);
-
-            if (HasPext)
-                m.attacks[pext(b, m.mask)] = reference[size];
-
             size++;
             b = (b - m.mask) & m.mask;
         } while (b);
 
-        if (HasPext)
-            continue;
-
 #ifndef PRECOMPUTED_MAGICS
         PRNG rng(seeds[Is64Bit][rank_of(s)]);
 #endif
@@ -440,10 +451,13 @@ namespace {
                     break;
             }
         }
+#endif
     }
 
+#ifndef USE_PEXT
     delete[] occupancy;
     delete[] reference;
     delete[] epoch;
+#endif
   }
 }
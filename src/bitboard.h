@@ -114,19 +114,34 @@ extern RiderType MoveRiderTypes[PIECE_TYPE_NB];
 int popcount(Bitboard b); // required for 128 bit pext
 #endif
 
-/// Magic holds all magic bitboards relevant data for a single square
+/// Magic holds all magic bitboards relevant data for a single square. With
+/// pext the index is extracted directly from the occupancy, so only the mask
+/// and the attacks table are needed and the magic factors are dropped.
 struct Magic {
   Bitboard  mask;
+#ifndef USE_PEXT
   Bitboard  magic;
+#endif
   Bitboard* attacks;
+#ifdef USE_PEXT
+#ifdef LARGEBOARDS
+  unsigned  lowBits; // Number of bits of the mask in the lower 64 bits
+#endif
+
+  // Compute the attack's index using the pext instruction
+  unsigned index(Bitboard occupied) const {
+#ifdef LARGEBOARDS
+    return unsigned(pext_128(occupied, mask, lowBits));
+#else
+    return unsigned(pext(occupied, mask));
+#endif
+  }
+#else
   unsigned  shift;
 
   // Compute the attack's index using the 'magic bitboards' approach
   unsigned index(Bitboard occupied) const {
 
-    if (HasPext)
-        return unsigned(pext(occupied, mask));
-
 #ifndef LARGEBOARDS
     if (Is64Bit)
 #endif
@@ -136,6 +151,7 @@ struct Magic {
     unsigned hi = unsigned(occupied >> 32) & unsigned(mask >> 32);
     return (lo * unsigned(magic) ^ hi * unsigned(magic >> 32)) >> shift;
   }
+#endif
 };
 
 extern Magic RookMagicsH[SQUARE_NB];
@@ -503,18 +519,20 @@ inline int popcount(Bitboard b) {
 inline Square lsb(Bitboard b) {
   assert(b);
 #ifdef LARGEBOARDS
-  if (!(b << 64))
-      return Square(__builtin_ctzll(b >> 64) + 64);
-#endif
+  // Work on the two 64-bit halves, so that the selection of the half
+  // compiles to a conditional move instead of 128-bit shifts and a branch.
+  const uint64_t lo = uint64_t(b), hi = uint64_t(b >> 64);
+  return Square(lo ? __builtin_ctzll(lo) : __builtin_ctzll(hi) + 64);
+#else
   return Square(__builtin_ctzll(b));
+#endif
 }
 
 inline Square msb(Bitboard b) {
   assert(b);
 #ifdef LARGEBOARDS
-  if (b >> 64)
-      return Square(int(SQUARE_BIT_MASK) ^ __builtin_clzll(b >> 64));
-  return Square(int(SQUARE_BIT_MASK) ^ (__builtin_clzll(b) + 64));
+  const uint64_t lo = uint64_t(b), hi = uint64_t(b >> 64);
+  return Square(int(SQUARE_BIT_MASK) ^ (hi ? __builtin_clzll(hi) : __builtin_clzll(lo) + 64));
 #else
   return Square(int(SQUARE_BIT_MASK) ^ __builtin_clzll(b));
 #endif
@@ -42,6 +42,10 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <limits>
 #include <climits>
 #include <optional>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <chrono>
 
 #if (defined(_MSC_VER) || defined(__INTEL_COMPILER)) && !defined(__clang__)
 #include <intrin.h>
@@ -6140,6 +6144,17 @@ namespace binpack
             m_file.write(data, size);
         }
 
+        // Append data that already consists of complete chunks, headers included.
+        void appendChunks(const char* data, std::size_t size)
+        {
+            m_file.write(data, size);
+        }
+
+        void flush()
+        {
+            m_file.flush();
+        }
+
         [[nodiscard]] bool hasNextChunk()
         {
             m_file.peek();
@@ -6154,13 +6169,29 @@ namespace binpack
             return data;
         }
 
-    private:
-        std::string m_path;
-        std::fstream m_file;
+        // Read the chunk whose header starts at the given offset.
+        [[nodiscard]] std::vector<unsigned char> readChunkAt(std::uint64_t offset)
+        {
+            m_file.clear();
+            m_file.seekg(offset);
+            return readNextChunk();
+        }
 
-        void writeChunkHeader(Header h)
+        // Skip the data of the next chunk and return its size.
+        [[nodiscard]] std::uint32_t skipNextChunk()
+        {
+            auto size = readChunkHeader().chunkSize;
+            m_file.seekg(size, std::ios_base::cur);
+            return size;
+        }
+
+        [[nodiscard]] std::uint64_t tell()
+        {
+            return m_file.tellg();
+        }
+
+        static void makeChunkHeader(unsigned char* header, Header h)
         {
-            unsigned char header[8];
             header[0] = 'B';
             header[1] = 'I';
             header[2] = 'N';
@@ -6169,6 +6200,16 @@ namespace binpack
             header[5] = h.chunkSize >> 8;
             header[6] = h.chunkSize >> 16;
             header[7] = h.chunkSize >> 24;
+        }
+
+    private:
+        std::string m_path;
+        std::fstream m_file;
+
+        void writeChunkHeader(Header h)
+        {
+            unsigned char header[8];
+            makeChunkHeader(header, h);
             m_file.write(reinterpret_cast<const char*>(header), 8);
         }
 
@@ -6716,12 +6757,13 @@ namespace binpack
         return plain;
     }
 
-    struct CompressedTrainingDataEntryWriter
+    // Groups entries into chunks. Calls sink(data, size) for the data of
+    // each complete chunk, the chunk header is not included.
+    struct CompressedTrainingDataChunkEncoder
     {
         static constexpr std::size_t chunkSize = suggestedChunkSize;
 
-        CompressedTrainingDataEntryWriter(std::string path, std::ios_base::openmode om = std::ios_base::app) :
-            m_outputFile(path, om),
+        CompressedTrainingDataChunkEncoder() :
             m_lastEntry{},
             m_movelist{},
             m_packedSize(0),
@@ -6732,7 +6774,8 @@ namespace binpack
             m_lastEntry.result = 0x7FFF;
         }
 
-        void addTrainingDataEntry(const TrainingDataEntry& e)
+        template <typename SinkT>
+        void addTrainingDataEntry(const TrainingDataEntry& e, SinkT&& sink)
         {
             bool isCont = isContinuation(m_lastEntry, e);
             if (isCont)
@@ -6749,7 +6792,7 @@ namespace binpack
 
                 if (m_packedSize >= chunkSize)
                 {
-                    m_outputFile.append(m_packedEntries.data(), m_packedSize);
+                    sink(m_packedEntries.data(), m_packedSize);
                     m_packedSize = 0;
                 }
 
@@ -6765,7 +6808,8 @@ namespace binpack
             m_lastEntry = e;
         }
 
-        ~CompressedTrainingDataEntryWriter()
+        template <typename SinkT>
+        void finish(SinkT&& sink)
         {
             if (m_packedSize > 0)
             {
@@ -6774,13 +6818,12 @@ namespace binpack
                     writeMovelist();
                 }
 
-                m_outputFile.append(m_packedEntries.data(), m_packedSize);
+                sink(m_packedEntries.data(), m_packedSize);
                 m_packedSize = 0;
             }
         }
 
     private:
-        CompressedTrainingDataFile m_outputFile;
         TrainingDataEntry m_lastEntry;
         PackedMoveScoreList m_movelist;
         std::size_t m_packedSize;
@@ -6799,6 +6842,34 @@ namespace binpack
         };
     };
 
+    struct CompressedTrainingDataEntryWriter
+    {
+        static constexpr std::size_t chunkSize = suggestedChunkSize;
+
+        CompressedTrainingDataEntryWriter(std::string path, std::ios_base::openmode om = std::ios_base::app) :
+            m_outputFile(path, om)
+        {
+        }
+
+        void addTrainingDataEntry(const TrainingDataEntry& e)
+        {
+            m_encoder.addTrainingDataEntry(e, [this](const char* data, std::size_t size) {
+                m_outputFile.append(data, size);
+            });
+        }
+
+        ~CompressedTrainingDataEntryWriter()
+        {
+            m_encoder.finish([this](const char* data, std::size_t size) {
+                m_outputFile.append(data, size);
+            });
+        }
+
+    private:
+        CompressedTrainingDataFile m_outputFile;
+        CompressedTrainingDataChunkEncoder m_encoder;
+    };
+
     struct CompressedTrainingDataEntryReader
     {
         static constexpr std::size_t chunkSize = suggestedChunkSize;
@@ -6887,6 +6958,385 @@ namespace binpack
         }
     };
 
+    // Decode all entries of a chunk as returned by readNextChunk.
+    [[nodiscard]] inline std::vector<TrainingDataEntry> decodeChunk(std::vector<unsigned char>& chunk)
+    {
+        std::vector<TrainingDataEntry> entries;
+
+        std::size_t offset = 0;
+        while (offset + sizeof(PackedTrainingDataEntry) + 2 <= chunk.size())
+        {
+            PackedTrainingDataEntry packed;
+            std::memcpy(&packed, chunk.data() + offset, sizeof(PackedTrainingDataEntry));
+            offset += sizeof(PackedTrainingDataEntry);
+
+            const std::uint16_t numPlies = (chunk[offset] << 8) | chunk[offset + 1];
+            offset += 2;
+
+            const auto e = unpackEntry(packed);
+            entries.emplace_back(e);
+
+            if (numPlies > 0)
+            {
+                PackedMoveScoreListReader movelistReader(e, chunk.data() + offset, numPlies);
+                while (movelistReader.hasNext())
+                {
+                    entries.emplace_back(movelistReader.nextEntry());
+                }
+                offset += movelistReader.numReadBytes();
+            }
+        }
+
+        return entries;
+    }
+
+    // Encode the entries into one or more complete chunks, headers included,
+    // ready to be passed to CompressedTrainingDataFile::appendChunks.
+    [[nodiscard]] inline std::vector<char> encodeChunks(const std::vector<TrainingDataEntry>& entries)
+    {
+        std::vector<char> out;
+        CompressedTrainingDataChunkEncoder encoder;
+
+        auto sink = [&out](const char* data, std::size_t size) {
+            unsigned char header[8];
+            CompressedTrainingDataFile::makeChunkHeader(header, { static_cast<std::uint32_t>(size) });
+            out.insert(out.end(), header, header + 8);
+            out.insert(out.end(), data, data + size);
+        };
+
+        for (const auto& e : entries)
+        {
+            encoder.addTrainingDataEntry(e, sink);
+        }
+        encoder.finish(sink);
+
+        return out;
+    }
+
+    // Position of a chunk in a file. The offset points at the chunk header,
+    // the size is the size of the chunk data.
+    struct ChunkLocation
+    {
+        std::uint64_t offset;
+        std::uint32_t size;
+    };
+
+    [[nodiscard]] inline std::vector<ChunkLocation> scanChunkLocations(const std::string& path)
+    {
+        CompressedTrainingDataFile file(path, std::ios_base::in);
+        std::vector<ChunkLocation> locations;
+
+        while (file.hasNextChunk())
+        {
+            const auto offset = file.tell();
+            const auto size = file.skipNextChunk();
+            locations.push_back({ offset, size });
+        }
+
+        return locations;
+    }
+
+    // The chunk index is stored next to the data file in path + ".index":
+    //   "BPIX", u64 size of the data file, u64 number of chunks,
+    //   then for each chunk u64 offset and u32 size,
+    // all little endian. The index is only used when the size of the data
+    // file still matches.
+    [[nodiscard]] inline std::string chunkIndexPath(const std::string& path)
+    {
+        return path + ".index";
+    }
+
+    namespace detail
+    {
+        inline void writeLE(std::ostream& out, std::uint64_t value, int numBytes)
+        {
+            for (int i = 0; i < numBytes; ++i)
+            {
+                out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        [[nodiscard]] inline std::uint64_t readLE(std::istream& in, int numBytes)
+        {
+            unsigned char bytes[8];
+            in.read(reinterpret_cast<char*>(bytes), numBytes);
+
+            std::uint64_t value = 0;
+            for (int i = 0; i < numBytes; ++i)
+            {
+                value |= std::uint64_t(bytes[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        [[nodiscard]] inline std::uint64_t fileSize(const std::string& path)
+        {
+            std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+            return file ? static_cast<std::uint64_t>(file.tellg()) : 0;
+        }
+    }
+
+    inline void writeChunkIndex(const std::string& path, const std::vector<ChunkLocation>& locations)
+    {
+        std::ofstream out(chunkIndexPath(path), std::ios_base::binary | std::ios_base::trunc);
+        out.write("BPIX", 4);
+        detail::writeLE(out, detail::fileSize(path), 8);
+        detail::writeLE(out, locations.size(), 8);
+        for (const auto& loc : locations)
+        {
+            detail::writeLE(out, loc.offset, 8);
+            detail::writeLE(out, loc.size, 4);
+        }
+    }
+
+    inline void writeChunkIndex(const std::string& path)
+    {
+        writeChunkIndex(path, scanChunkLocations(path));
+    }
+
+    [[nodiscard]] inline std::optional<std::vector<ChunkLocation>> readChunkIndex(const std::string& path)
+    {
+        std::ifstream in(chunkIndexPath(path), std::ios_base::binary);
+        if (!in)
+        {
+            return std::nullopt;
+        }
+
+        char magic[4];
+        in.read(magic, 4);
+        if (!in || std::memcmp(magic, "BPIX", 4) != 0)
+        {
+            return std::nullopt;
+        }
+
+        const auto dataSize = detail::readLE(in, 8);
+        const auto numChunks = detail::readLE(in, 8);
+        if (!in || dataSize != detail::fileSize(path))
+        {
+            return std::nullopt;
+        }
+
+        std::vector<ChunkLocation> locations;
+        for (std::uint64_t i = 0; i < numChunks && in; ++i)
+        {
+            const auto offset = detail::readLE(in, 8);
+            const auto size = detail::readLE(in, 4);
+            locations.push_back({ offset, static_cast<std::uint32_t>(size) });
+        }
+
+        if (!in)
+        {
+            return std::nullopt;
+        }
+
+        return locations;
+    }
+
+    // Uses the index file if there is a valid one, otherwise scans the chunk headers.
+    [[nodiscard]] inline std::vector<ChunkLocation> chunkLocations(const std::string& path)
+    {
+        auto locations = readChunkIndex(path);
+        return locations.has_value() ? std::move(*locations) : scanChunkLocations(path);
+    }
+
+    // Reads chunks in sequence and decodes up to numThreads of them concurrently.
+    // With keepOrder == false the chunks are returned as soon as they are decoded,
+    // which may differ from the order in the file.
+    struct CompressedTrainingDataEntryParallelReader
+    {
+        CompressedTrainingDataEntryParallelReader(std::string path, std::size_t numThreads, bool keepOrder = true) :
+            CompressedTrainingDataEntryParallelReader(path, chunkLocations(path), numThreads, keepOrder)
+        {
+        }
+
+        // Only read the given chunks, for example a range of chunkLocations(path).
+        CompressedTrainingDataEntryParallelReader(std::string path, std::vector<ChunkLocation> locations, std::size_t numThreads, bool keepOrder = true) :
+            m_inputFile(path, std::ios_base::in),
+            m_locations(std::move(locations)),
+            m_nextChunk(0),
+            m_numThreads(std::max<std::size_t>(numThreads, 1)),
+            m_keepOrder(keepOrder),
+            m_entries(),
+            m_offset(0)
+        {
+            fetchNextChunk();
+        }
+
+        [[nodiscard]] bool hasNext()
+        {
+            return m_offset < m_entries.size();
+        }
+
+        [[nodiscard]] TrainingDataEntry next()
+        {
+            const auto e = m_entries[m_offset++];
+
+            if (m_offset >= m_entries.size())
+            {
+                fetchNextChunk();
+            }
+
+            return e;
+        }
+
+        ~CompressedTrainingDataEntryParallelReader()
+        {
+            for (auto& f : m_pending)
+            {
+                f.wait();
+            }
+        }
+
+    private:
+        CompressedTrainingDataFile m_inputFile;
+        std::vector<ChunkLocation> m_locations;
+        std::size_t m_nextChunk;
+        std::size_t m_numThreads;
+        bool m_keepOrder;
+        std::deque<std::future<std::vector<TrainingDataEntry>>> m_pending;
+        std::vector<TrainingDataEntry> m_entries;
+        std::size_t m_offset;
+
+        void fetchNextChunk()
+        {
+            m_entries.clear();
+            m_offset = 0;
+
+            while (m_entries.empty())
+            {
+                while (m_pending.size() < m_numThreads && m_nextChunk < m_locations.size())
+                {
+                    auto chunk = m_inputFile.readChunkAt(m_locations[m_nextChunk++].offset);
+                    m_pending.emplace_back(std::async(std::launch::async, [chunk = std::move(chunk)]() mutable {
+                        return decodeChunk(chunk);
+                    }));
+                }
+
+                if (m_pending.empty())
+                {
+                    return;
+                }
+
+                auto it = m_pending.begin();
+                if (!m_keepOrder)
+                {
+                    auto ready = std::find_if(m_pending.begin(), m_pending.end(), [](auto& f) {
+                        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                    });
+                    if (ready != m_pending.end())
+                    {
+                        it = ready;
+                    }
+                }
+
+                m_entries = it->get();
+                m_pending.erase(it);
+            }
+        }
+    };
+
+    // Collects entries in batches and encodes up to numThreads batches concurrently.
+    // The chunks are written in the order of the entries. A game that spans two
+    // batches is stored as two chains, which costs a little space.
+    struct CompressedTrainingDataEntryParallelWriter
+    {
+        static constexpr std::size_t batchSize = 1 << 18;
+
+        CompressedTrainingDataEntryParallelWriter(std::string path, std::size_t numThreads, std::ios_base::openmode om = std::ios_base::app) :
+            m_outputFile(path, om),
+            m_numThreads(std::max<std::size_t>(numThreads, 1))
+        {
+            m_batch.reserve(batchSize);
+        }
+
+        void addTrainingDataEntry(const TrainingDataEntry& e)
+        {
+            m_batch.emplace_back(e);
+
+            if (m_batch.size() >= batchSize)
+            {
+                submitBatch();
+            }
+        }
+
+        ~CompressedTrainingDataEntryParallelWriter()
+        {
+            if (!m_batch.empty())
+            {
+                submitBatch();
+            }
+
+            while (!m_pending.empty())
+            {
+                writeFront();
+            }
+
+            m_outputFile.flush();
+        }
+
+    private:
+        CompressedTrainingDataFile m_outputFile;
+        std::size_t m_numThreads;
+        std::vector<TrainingDataEntry> m_batch;
+        std::deque<std::future<std::vector<char>>> m_pending;
+
+        void submitBatch()
+        {
+            if (m_pending.size() >= m_numThreads)
+            {
+                writeFront();
+            }
+
+            m_pending.emplace_back(std::async(std::launch::async, [batch = std::move(m_batch)]() {
+                return encodeChunks(batch);
+            }));
+
+            m_batch = std::vector<TrainingDataEntry>();
+            m_batch.reserve(batchSize);
+        }
+
+        void writeFront()
+        {
+            const auto data = m_pending.front().get();
+            m_pending.pop_front();
+            m_outputFile.appendChunks(data.data(), data.size());
+        }
+    };
+
+    // Calls func with the sequential writer for a single thread, so that games are
+    // not split at batch boundaries, and with the parallel writer otherwise.
+    template <typename FuncT>
+    inline void withTrainingDataEntryWriter(std::string path, std::ios_base::openmode om, std::size_t numThreads, FuncT&& func)
+    {
+        if (numThreads > 1)
+        {
+            CompressedTrainingDataEntryParallelWriter writer(path, numThreads, om);
+            func(writer);
+        }
+        else
+        {
+            CompressedTrainingDataEntryWriter writer(path, om);
+            func(writer);
+        }
+    }
+
+    // Calls func with the sequential reader for a single thread and with the
+    // parallel reader otherwise.
+    template <typename FuncT>
+    inline void withTrainingDataEntryReader(std::string path, std::size_t numThreads, FuncT&& func)
+    {
+        if (numThreads > 1)
+        {
+            CompressedTrainingDataEntryParallelReader reader(path, numThreads);
+            func(reader);
+        }
+        else
+        {
+            CompressedTrainingDataEntryReader reader(path);
+            func(reader);
+        }
+    }
+
     inline void emitPlainEntry(std::string& buffer, const TrainingDataEntry& plain)
     {
         buffer += "fen ";
@@ -6917,176 +7367,180 @@ namespace binpack
         buffer.insert(buffer.end(), data, data+sizeof(psv));
     }
 
-    inline void convertPlainToBinpack(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertPlainToBinpack(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t numThreads)
     {
         constexpr std::size_t reportEveryNPositions = 100'000;
 
         std::cout << "Converting " << inputPath << " to " << outputPath << '\n';
 
-        CompressedTrainingDataEntryWriter writer(outputPath, om);
-        TrainingDataEntry e;
+        withTrainingDataEntryWriter(outputPath, om, numThreads, [&](auto& writer) {
+            TrainingDataEntry e;
 
-        std::string key;
-        std::string value;
-        std::string move;
+            std::string key;
+            std::string value;
+            std::string move;
 
-        std::ifstream inputFile(inputPath);
-        const auto base = inputFile.tellg();
-        std::size_t numProcessedPositions = 0;
+            std::ifstream inputFile(inputPath);
+            const auto base = inputFile.tellg();
+            std::size_t numProcessedPositions = 0;
 
-        for(;;)
-        {
-            inputFile >> key;
-            if (!inputFile)
+            for(;;)
             {
-                break;
-            }
+                inputFile >> key;
+                if (!inputFile)
+                {
+                    break;
+                }
 
-            if (key == "e"sv)
-            {
-                e.move = chess::uci::uciToMove(e.pos, move);
+                if (key == "e"sv)
+                {
+                    e.move = chess::uci::uciToMove(e.pos, move);
 
-                writer.addTrainingDataEntry(e);
+                    writer.addTrainingDataEntry(e);
 
-                ++numProcessedPositions;
-                const auto cur = inputFile.tellg();
-                if (numProcessedPositions % reportEveryNPositions == 0)
-                {
-                    std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
-                }
+                    ++numProcessedPositions;
+                    const auto cur = inputFile.tellg();
+                    if (numProcessedPositions % reportEveryNPositions == 0)
+                    {
+                        std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
+                    }
 
-                continue;
-            }
+                    continue;
+                }
 
-            inputFile >> std::ws;
-            std::getline(inputFile, value, '\n');
+                inputFile >> std::ws;
+                std::getline(inputFile, value, '\n');
 
-            if (key == "fen"sv) e.pos = chess::Position::fromFen(value.c_str());
-            if (key == "move"sv) move = value;
-            if (key == "score"sv) e.score = std::stoi(value);
-            if (key == "ply"sv) e.ply = std::stoi(value);
-            if (key == "result"sv) e.result = std::stoi(value);
-        }
+                if (key == "fen"sv) e.pos = chess::Position::fromFen(value.c_str());
+                if (key == "move"sv) move = value;
+                if (key == "score"sv) e.score = std::stoi(value);
+                if (key == "ply"sv) e.ply = std::stoi(value);
+                if (key == "result"sv) e.result = std::stoi(value);
+            }
 
-        std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+            std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+        });
     }
 
-    inline void convertBinpackToPlain(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertBinpackToPlain(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t numThreads)
     {
         constexpr std::size_t bufferSize = MiB;
 
         std::cout << "Converting " << inputPath << " to " << outputPath << '\n';
 
-        CompressedTrainingDataEntryReader reader(inputPath);
-        std::ofstream outputFile(outputPath, om);
-        const auto base = outputFile.tellp();
-        std::size_t numProcessedPositions = 0;
-        std::string buffer;
-        buffer.reserve(bufferSize * 2);
+        withTrainingDataEntryReader(inputPath, numThreads, [&](auto& reader) {
+            std::ofstream outputFile(outputPath, om);
+            const auto base = outputFile.tellp();
+            std::size_t numProcessedPositions = 0;
+            std::string buffer;
+            buffer.reserve(bufferSize * 2);
 
-        while(reader.hasNext())
-        {
-            emitPlainEntry(buffer, reader.next());
+            while(reader.hasNext())
+            {
+                emitPlainEntry(buffer, reader.next());
 
-            ++numProcessedPositions;
+                ++numProcessedPositions;
 
-            if (buffer.size() > bufferSize)
+                if (buffer.size() > bufferSize)
+                {
+                    outputFile << buffer;
+                    buffer.clear();
+
+                    const auto cur = outputFile.tellp();
+                    std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
+                }
+            }
+
+            if (!buffer.empty())
             {
                 outputFile << buffer;
-                buffer.clear();
 
                 const auto cur = outputFile.tellp();
                 std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
             }
-        }
-
-        if (!buffer.empty())
-        {
-            outputFile << buffer;
 
-            const auto cur = outputFile.tellp();
-            std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
-        }
-
-        std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+            std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+        });
     }
 
 
-    inline void convertBinToBinpack(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertBinToBinpack(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t numThreads)
     {
         constexpr std::size_t reportEveryNPositions = 100'000;
 
         std::cout << "Converting " << inputPath << " to " << outputPath << '\n';
 
-        CompressedTrainingDataEntryWriter writer(outputPath, om);
+        withTrainingDataEntryWriter(outputPath, om, numThreads, [&](auto& writer) {
 
-        std::ifstream inputFile(inputPath, std::ios_base::binary);
-        const auto base = inputFile.tellg();
-        std::size_t numProcessedPositions = 0;
+            std::ifstream inputFile(inputPath, std::ios_base::binary);
+            const auto base = inputFile.tellg();
+            std::size_t numProcessedPositions = 0;
 
-        nodchip::PackedSfenValue psv;
-        for(;;)
-        {
-            inputFile.read(reinterpret_cast<char*>(&psv), sizeof(psv));
-            if (inputFile.gcount() != 40)
+            nodchip::PackedSfenValue psv;
+            for(;;)
             {
-                break;
-            }
+                inputFile.read(reinterpret_cast<char*>(&psv), sizeof(psv));
+                if (inputFile.gcount() != 40)
+                {
+                    break;
+                }
 
-            writer.addTrainingDataEntry(packedSfenValueToTrainingDataEntry(psv));
+                writer.addTrainingDataEntry(packedSfenValueToTrainingDataEntry(psv));
 
-            ++numProcessedPositions;
-            const auto cur = inputFile.tellg();
-            if (numProcessedPositions % reportEveryNPositions == 0)
-            {
-                std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
+                ++numProcessedPositions;
+                const auto cur = inputFile.tellg();
+                if (numProcessedPositions % reportEveryNPositions == 0)
+                {
+                    std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
+                }
             }
-        }
 
-        std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+            std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+        });
     }
 
-    inline void convertBinpackToBin(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertBinpackToBin(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t numThreads)
     {
         constexpr std::size_t bufferSize = MiB;
 
         std::cout << "Converting " << inputPath << " to " << outputPath << '\n';
 
-        CompressedTrainingDataEntryReader reader(inputPath);
-        std::ofstream outputFile(outputPath, std::ios_base::binary | om);
-        const auto base = outputFile.tellp();
-        std::size_t numProcessedPositions = 0;
-        std::vector<char> buffer;
-        buffer.reserve(bufferSize * 2);
+        withTrainingDataEntryReader(inputPath, numThreads, [&](auto& reader) {
+            std::ofstream outputFile(outputPath, std::ios_base::binary | om);
+            const auto base = outputFile.tellp();
+            std::size_t numProcessedPositions = 0;
+            std::vector<char> buffer;
+            buffer.reserve(bufferSize * 2);
 
-        while(reader.hasNext())
-        {
-            emitBinEntry(buffer, reader.next());
+            while(reader.hasNext())
+            {
+                emitBinEntry(buffer, reader.next());
 
-            ++numProcessedPositions;
+                ++numProcessedPositions;
 
-            if (buffer.size() > bufferSize)
+                if (buffer.size() > bufferSize)
+                {
+                    outputFile.write(buffer.data(), buffer.size());
+                    buffer.clear();
+
+                    const auto cur = outputFile.tellp();
+                    std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
+                }
+            }
+
+            if (!buffer.empty())
             {
                 outputFile.write(buffer.data(), buffer.size());
-                buffer.clear();
 
                 const auto cur = outputFile.tellp();
                 std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
             }
-        }
-
-        if (!buffer.empty())
-        {
-            outputFile.write(buffer.data(), buffer.size());
 
-            const auto cur = outputFile.tellp();
-            std::cout << "Processed " << (cur - base) << " bytes and " << numProcessedPositions << " positions.\n";
-        }
-
-        std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+            std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
+        });
     }
 
-    inline void convertBinToPlain(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertBinToPlain(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t /* numThreads */)
     {
         constexpr std::size_t bufferSize = MiB;
 
@@ -7134,7 +7588,7 @@ namespace binpack
         std::cout << "Finished. Converted " << numProcessedPositions << " positions.\n";
     }
 
-    inline void convertPlainToBin(std::string inputPath, std::string outputPath, std::ios_base::openmode om)
+    inline void convertPlainToBin(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t /* numThreads */)
     {
         constexpr std::size_t bufferSize = MiB;
 
@@ -0,0 +1,380 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nnue/evaluate_nnue.h"
+
+#include "bitboard.h"
+#include "endgame.h"
+#include "fairystockfish.h"
+#include "movegen.h"
+#include "position.h"
+#include "search.h"
+#include "thread.h"
+#include "tune.h"
+#include "uci.h"
+
+#include "piece.h"
+#include "variant.h"
+
+/// fsf_position keeps the moves played from its initial position, so that
+/// moves can be taken back and searches see the game history.
+struct fsf_position {
+  std::string variant, fen;
+  bool chess960;
+  StateListPtr states;
+  std::vector<Move> moves;
+  Position pos;
+};
+
+namespace {
+
+  bool Initialized = false;
+
+  // Thread of the API positions. Positions count their moves as nodes of their
+  // thread, so they do not use the threads of the pool, which may be replaced
+  // by setting Threads and which count the nodes of the running search.
+  Thread* PositionThread = nullptr;
+
+  // Passes the output of the search to the callbacks of fsf_search_start().
+  // Without callbacks, e.g., while setting options, the output is discarded,
+  // since the library must not write to stdout of the embedding process.
+  void set_hooks(fsf_info_callback info, fsf_bestmove_callback bestmove, void* user) {
+
+      Search::Hooks.pv = [=](const Search::PVLine& l) {
+          if (!info)
+              return;
+
+          const bool mate = abs(l.score) >= VALUE_MATE_IN_MAX_PLY;
+          fsf_info i = {};
+          i.line = l.text.c_str();
+          i.depth = l.depth;
+          i.seldepth = l.selDepth;
+          i.multipv = int32_t(l.multiPV);
+          i.score_is_mate = mate;
+          i.score =  !mate      ? l.score * 100 / PawnValueEg
+                   : l.score > 0 ? (VALUE_MATE - l.score + 1) / 2 : (-VALUE_MATE - l.score - 1) / 2;
+          i.nodes = l.nodes;
+          i.nps = l.nps;
+          i.time = uint64_t(l.time);
+          i.pv = reinterpret_cast<const fsf_move*>(l.pv.data());
+          i.pv_length = l.pv.size();
+          info(&i, user);
+      };
+
+      Search::Hooks.line = [=](const std::string& line) {
+          if (!info)
+              return;
+
+          fsf_info i = {};
+          i.line = line.c_str();
+          info(&i, user);
+      };
+
+      Search::Hooks.bestmove = [=](Move best, Move ponder) {
+          if (bestmove)
+              bestmove(fsf_move(best), fsf_move(ponder), user);
+      };
+  }
+
+  size_t copy_string(const std::string& s, char* buf, size_t size) {
+
+    if (size)
+    {
+        size_t n = std::min(s.size(), size - 1);
+        std::memcpy(buf, s.data(), n);
+        buf[n] = '\0';
+    }
+    return s.size();
+  }
+
+  fsf_status load_variants(std::istream& is) {
+
+    Threads.main()->wait_for_search_finished();
+    set_hooks(nullptr, nullptr, nullptr);
+    variants.parse_istream<false>(is);
+    Options["UCI_Variant"].set_combo(variants.get_keys());
+    return FSF_OK;
+  }
+
+} // namespace
+
+static_assert(sizeof(Move) == sizeof(fsf_move), "Moves are passed as fsf_move");
+
+
+extern "C" {
+
+int fsf_api_version() { return FSF_API_VERSION; }
+
+const char* fsf_engine_info() {
+
+  static const std::string info = engine_info();
+  return info.c_str();
+}
+
+/// fsf_init() initializes the engine like main() does. It may be called more
+/// than once.
+
+fsf_status fsf_init() {
+
+  if (Initialized)
+      return FSF_OK;
+
+  char argv0[] = "libfairystockfish";
+  char* argv[] = { argv0, nullptr };
+
+  set_hooks(nullptr, nullptr, nullptr);
+  pieceMap.init();
+  variants.init();
+  CommandLine::init(1, argv);
+  UCI::init(Options);
+  Tune::init();
+  Bitboards::init();
+  Position::init();
+  Bitbases::init();
+  Endgames::init();
+  Threads.set(size_t(Options["Threads"]));
+  Search::clear(); // After threads are up
+  Eval::NNUE::init();
+  PositionThread = new Thread(0);
+
+  Initialized = true;
+  return FSF_OK;
+}
+
+void fsf_shutdown() {
+
+  if (!Initialized)
+      return;
+
+  Threads.stop = true;
+  Threads.main()->wait_for_search_finished();
+  Eval::NNUE::wait_for_net_swap();
+  Threads.set(0);
+  delete PositionThread;
+  PositionThread = nullptr;
+  Search::Hooks = Search::OutputHooks();
+  variants.clear_all();
+  pieceMap.clear_all();
+  Initialized = false;
+}
+
+fsf_status fsf_set_option(const char* name, const char* value) {
+
+  if (!Initialized)
+      return FSF_ERR_NOT_INITIALIZED;
+
+  if (!Options.count(name))
+      return FSF_ERR_UNKNOWN_OPTION;
+
+  if (Threads.main()->is_searching())
+      return FSF_ERR_SEARCHING;
+
+  set_hooks(nullptr, nullptr, nullptr);
+  Options[name] = std::string(value);
+
+  // The engine would exit at the next search without a net, see
+  // Eval::NNUE::verify_eval_file_loaded()
+  return Eval::NNUE::is_eval_file_loaded() ? FSF_OK : FSF_ERR_NO_NET;
+}
+
+fsf_status fsf_load_variants(const char* path) {
+
+  if (!Initialized)
+      return FSF_ERR_NOT_INITIALIZED;
+
+  std::ifstream file(path);
+  return file.is_open() ? load_variants(file) : FSF_ERR_FILE;
+}
+
+fsf_status fsf_load_variant_config(const char* config) {
+
+  if (!Initialized)
+      return FSF_ERR_NOT_INITIALIZED;
+
+  std::istringstream ss(config);
+  return load_variants(ss);
+}
+
+size_t fsf_max_moves() { return MAX_MOVES; }
+
+/// fsf_position_new() creates a position of a variant, from its start position
+/// if fen is NULL. Returns NULL if the engine is not initialized or the
+/// variant is unknown. The FEN is not validated, as with the "position" command.
+
+fsf_position* fsf_position_new(const char* variant, const char* fen, int chess960) {
+
+  if (!Initialized || !variants.count(variant))
+      return nullptr;
+
+  const Variant* v = variants.find(variant)->second;
+  fsf_position* p = new fsf_position();
+  p->variant = variant;
+  p->fen = fen ? fen : v->startFen;
+  p->chess960 = chess960;
+  p->states = StateListPtr(new std::deque<StateInfo>(1));
+  p->pos.set(v, p->fen, p->chess960, &p->states->back(), PositionThread);
+  return p;
+}
+
+fsf_position* fsf_position_copy(const fsf_position* pos) {
+
+  fsf_position* p = fsf_position_new(pos->variant.c_str(), pos->fen.c_str(), pos->chess960);
+  if (p)
+      for (Move m : pos->moves)
+          fsf_position_do_move(p, m);
+  return p;
+}
+
+void fsf_position_free(fsf_position* pos) { delete pos; }
+
+size_t fsf_position_fen(const fsf_position* pos, char* buf, size_t size) {
+  return copy_string(pos->pos.fen(), buf, size);
+}
+
+int fsf_position_side_to_move(const fsf_position* pos) { return pos->pos.side_to_move(); }
+
+int fsf_position_in_check(const fsf_position* pos) { return bool(pos->pos.checkers()); }
+
+fsf_result fsf_position_result(const fsf_position* pos) {
+
+  Value result;
+  if (!pos->pos.is_game_end(result))
+  {
+      if (MoveList<LEGAL>(pos->pos).size())
+          return FSF_ONGOING;
+      result = pos->pos.checkers() ? pos->pos.checkmate_value() : pos->pos.stalemate_value();
+  }
+  return result > VALUE_DRAW ? FSF_WIN : result < VALUE_DRAW ? FSF_LOSS : FSF_DRAW;
+}
+
+size_t fsf_position_legal_moves(const fsf_position* pos, fsf_move* moves, size_t size) {
+
+  MoveList<LEGAL> list(pos->pos);
+  size_t n = 0;
+  for (const auto& m : list)
+      if (n < size)
+          moves[n++] = fsf_move(Move(m));
+  return list.size();
+}
+
+fsf_status fsf_position_do_move(fsf_position* pos, fsf_move move) {
+
+  Move m = Move(move);
+  if (!MoveList<LEGAL>(pos->pos).contains(m))
+      return FSF_ERR_ILLEGAL_MOVE;
+
+  pos->states->emplace_back();
+  pos->pos.do_move(m, pos->states->back());
+  pos->moves.push_back(m);
+  return FSF_OK;
+}
+
+fsf_status fsf_position_undo_move(fsf_position* pos) {
+
+  if (pos->moves.empty())
+      return FSF_ERR_NO_MOVE;
+
+  pos->pos.undo_move(pos->moves.back());
+  pos->states->pop_back();
+  pos->moves.pop_back();
+  return FSF_OK;
+}
+
+fsf_move fsf_position_parse_move(const fsf_position* pos, const char* move) {
+
+  std::string str(move);
+  return fsf_move(UCI::to_move(pos->pos, str));
+}
+
+size_t fsf_position_move_string(const fsf_position* pos, fsf_move move, char* buf, size_t size) {
+  return copy_string(UCI::move(pos->pos, Move(move)), buf, size);
+}
+
+/// fsf_search_start() searches a position in the background. The position
+/// may be changed or freed afterwards, since the search uses a copy.
+
+fsf_status fsf_search_start(const fsf_position* pos, const fsf_limits* limits,
+                            fsf_info_callback info, fsf_bestmove_callback bestmove, void* user) {
+
+  if (!Initialized)
+      return FSF_ERR_NOT_INITIALIZED;
+
+  if (Threads.main()->is_searching())
+      return FSF_ERR_SEARCHING;
+
+  set_hooks(info, bestmove, user);
+
+  if (std::string(Options["UCI_Variant"]) != pos->variant)
+      Options["UCI_Variant"] = pos->variant;
+
+  if (!Eval::NNUE::is_eval_file_loaded())
+  {
+      set_hooks(nullptr, nullptr, nullptr);
+      return FSF_ERR_NO_NET;
+  }
+
+  // The states are handed over to the thread pool, which keeps them until
+  // the next search
+  StateListPtr states(new std::deque<StateInfo>(1));
+  Position root;
+  root.set(variants.find(pos->variant)->second, pos->fen, pos->chess960, &states->back(), PositionThread);
+  for (Move m : pos->moves)
+  {
+      states->emplace_back();
+      root.do_move(m, states->back());
+  }
+
+  Search::LimitsType l;
+  l.startTime = now();
+  if (limits)
+  {
+      for (Color c : { WHITE, BLACK })
+          l.time[c] = limits->time[c], l.inc[c] = limits->inc[c];
+      l.movetime = limits->movetime;
+      l.nodes = limits->nodes;
+      l.movestogo = limits->movestogo;
+      l.depth = limits->depth;
+      l.mate = limits->mate;
+      l.infinite = limits->infinite;
+  }
+
+  Threads.start_thinking(root, states, l);
+  return FSF_OK;
+}
+
+void fsf_search_stop() {
+
+  if (Initialized)
+      Threads.stop = true;
+}
+
+void fsf_search_wait() {
+
+  if (Initialized)
+      Threads.main()->wait_for_search_finished();
+}
+
+} // extern "C"
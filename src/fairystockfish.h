@@ -0,0 +1,148 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FAIRYSTOCKFISH_H_INCLUDED
+#define FAIRYSTOCKFISH_H_INCLUDED
+
+/*
+  C API of libfairystockfish, built with "make lib". It embeds the engine in
+  a process without talking UCI over pipes.
+
+  The engine state (options, variants, threads and hash table) is global to
+  the process. Only one search runs at a time. Positions are independent
+  objects. Different positions may be used from different threads, also
+  during a search.
+
+  The API version is increased whenever a function or struct changes in an
+  incompatible way. Compare fsf_api_version() with FSF_API_VERSION at run
+  time to detect a mismatched library.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FSF_API_VERSION 1
+
+#if defined(_WIN32)
+#  define FSF_API __declspec(dllexport)
+#else
+#  define FSF_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  FSF_OK = 0,
+  FSF_ERR_NOT_INITIALIZED,
+  FSF_ERR_UNKNOWN_OPTION,
+  FSF_ERR_FILE,
+  FSF_ERR_ILLEGAL_MOVE,
+  FSF_ERR_NO_MOVE,
+  FSF_ERR_SEARCHING,
+  FSF_ERR_NO_NET  /* NNUE evaluation is enabled, but the net of EvalFile is not loaded */
+} fsf_status;
+
+typedef enum {
+  FSF_ONGOING = 0,
+  FSF_WIN,  /* For the side to move */
+  FSF_LOSS,
+  FSF_DRAW
+} fsf_result;
+
+/* Moves are only valid for the position they were generated or parsed for */
+typedef uint32_t fsf_move;
+#define FSF_MOVE_NONE 0
+
+typedef struct fsf_position fsf_position;
+
+/* Search limits. Zero fields are unused, and with all fields zero the search
+   runs until fsf_search_stop() or the maximum depth. Times are in milliseconds. */
+typedef struct {
+  int64_t time[2];  /* Remaining time of white and black */
+  int64_t inc[2];
+  int64_t movetime;
+  int64_t nodes;
+  int32_t movestogo;
+  int32_t depth;
+  int32_t mate;
+  int32_t infinite;
+} fsf_limits;
+
+/* A line of search output. For "info depth" lines the numeric fields and the
+   PV are set, for other lines, e.g., "info string", only the line. */
+typedef struct {
+  const char* line;
+  int32_t depth, seldepth, multipv;
+  int32_t score_is_mate;
+  int32_t score;  /* In centipawns, or the mate distance in moves */
+  uint64_t nodes, nps, time;
+  const fsf_move* pv;
+  size_t pv_length;
+} fsf_info;
+
+/* Callbacks are called from the search thread and must not start, stop or
+   wait for a search. The info and PV are only valid during the call. */
+typedef void (*fsf_info_callback)(const fsf_info* info, void* user);
+typedef void (*fsf_bestmove_callback)(fsf_move best, fsf_move ponder, void* user);
+
+/* Engine. fsf_init() has to be called first, and positions have to be freed
+   before fsf_shutdown(). Options can not be set during a search. Setting an
+   option returns FSF_ERR_NO_NET if it leaves no net to search with, but the
+   option is set. Output of the engine outside a search is discarded. */
+
+FSF_API int fsf_api_version(void);
+FSF_API const char* fsf_engine_info(void);
+FSF_API fsf_status fsf_init(void);
+FSF_API void fsf_shutdown(void);
+FSF_API fsf_status fsf_set_option(const char* name, const char* value);
+FSF_API fsf_status fsf_load_variants(const char* path);
+FSF_API fsf_status fsf_load_variant_config(const char* config);
+FSF_API size_t fsf_max_moves(void);
+
+/* Positions. Functions returning size_t write a NUL-terminated string into
+   buf, truncated to size bytes, and return its full length like snprintf. */
+
+FSF_API fsf_position* fsf_position_new(const char* variant, const char* fen, int chess960);
+FSF_API fsf_position* fsf_position_copy(const fsf_position* pos);
+FSF_API void fsf_position_free(fsf_position* pos);
+FSF_API size_t fsf_position_fen(const fsf_position* pos, char* buf, size_t size);
+FSF_API int fsf_position_side_to_move(const fsf_position* pos);  /* 0 white, 1 black */
+FSF_API int fsf_position_in_check(const fsf_position* pos);
+FSF_API fsf_result fsf_position_result(const fsf_position* pos);
+FSF_API size_t fsf_position_legal_moves(const fsf_position* pos, fsf_move* moves, size_t size);
+FSF_API fsf_status fsf_position_do_move(fsf_position* pos, fsf_move move);
+FSF_API fsf_status fsf_position_undo_move(fsf_position* pos);
+FSF_API fsf_move fsf_position_parse_move(const fsf_position* pos, const char* move);
+FSF_API size_t fsf_position_move_string(const fsf_position* pos, fsf_move move, char* buf, size_t size);
+
+/* Search. Only one search runs at a time, and fsf_search_start() returns
+   FSF_ERR_SEARCHING until the previous one has finished, and FSF_ERR_NO_NET
+   without a net for NNUE evaluation. */
+
+FSF_API fsf_status fsf_search_start(const fsf_position* pos, const fsf_limits* limits,
+                                    fsf_info_callback info, fsf_bestmove_callback bestmove, void* user);
+FSF_API void fsf_search_stop(void);
+FSF_API void fsf_search_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef FAIRYSTOCKFISH_H_INCLUDED */
@@ -0,0 +1,99 @@
+#ifndef _COMPRESSED_SFEN_H_
+#define _COMPRESSED_SFEN_H_
+
+#include "packed_sfen.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Learner {
+
+    // Append-only list of PackedSfenValue stored in a compact variable length
+    // encoding, so that more positions fit in the same memory. Each entry is
+    //   1 byte      : length n of the packed sfen without trailing zero bytes
+    //                 (bits 0-5) and game_result + 1 (bits 6-7)
+    //   n bytes     : packed sfen
+    //   2 + 2 bytes : score, move
+    //   1-3 bytes   : gamePly as a varint
+    // The padding byte is not stored. Typical entries take 25-30 bytes
+    // instead of 40.
+    struct CompressedPSVector
+    {
+        static constexpr size_t MaxEntrySize = 1 + sizeof(PackedSfen) + 4 + 3;
+
+        void push_back(const PackedSfenValue& psv)
+        {
+            static_assert(sizeof(PackedSfen) < 64);
+
+            size_t n = sizeof(PackedSfen);
+            while (n > 0 && psv.sfen.data[n - 1] == 0)
+                --n;
+
+            // Grow in small steps, these buffers are large and long lived.
+            if (data.size() + MaxEntrySize > data.capacity())
+                data.reserve(data.capacity() + data.capacity() / 8 + 64 * MaxEntrySize);
+
+            data.push_back(uint8_t(n | ((psv.game_result + 1) << 6)));
+            data.insert(data.end(), psv.sfen.data, psv.sfen.data + n);
+
+            uint8_t buf[4];
+            std::memcpy(buf, &psv.score, 2);
+            std::memcpy(buf + 2, &psv.move, 2);
+            data.insert(data.end(), buf, buf + 4);
+
+            uint16_t ply = psv.gamePly;
+            while (ply >= 0x80)
+            {
+                data.push_back(uint8_t(ply | 0x80));
+                ply >>= 7;
+            }
+            data.push_back(uint8_t(ply));
+
+            ++count;
+        }
+
+        // Decode all entries in the order they were added.
+        void decode(PSVector& out) const
+        {
+            out.resize(count);
+
+            const uint8_t* p = data.data();
+            for (auto& psv : out)
+            {
+                const size_t n = *p & 63;
+
+                psv = PackedSfenValue{};
+                psv.game_result = int8_t((*p++ >> 6) - 1);
+                std::memcpy(psv.sfen.data, p, n);
+                p += n;
+                std::memcpy(&psv.score, p, 2);
+                std::memcpy(&psv.move, p + 2, 2);
+                p += 4;
+
+                for (int shift = 0; ; shift += 7)
+                {
+                    psv.gamePly |= uint16_t((*p & 0x7F) << shift);
+                    if (!(*p++ & 0x80))
+                        break;
+                }
+            }
+        }
+
+        size_t size() const { return count; }
+        size_t memory() const { return data.capacity(); }
+
+        // Remove all entries but keep the memory for reuse.
+        void clear()
+        {
+            data.clear();
+            count = 0;
+        }
+
+    private:
+        std::vector<uint8_t> data;
+        size_t count = 0;
+    };
+}
+
+#endif
@@ -525,7 +525,7 @@ namespace Learner
             && ends_with(output_path, expected_output_extension);
     }
 
-    using ConvertFunctionType = void(std::string inputPath, std::string outputPath, std::ios_base::openmode om);
+    using ConvertFunctionType = void(std::string inputPath, std::string outputPath, std::ios_base::openmode om, std::size_t numThreads);
 
     static ConvertFunctionType* get_convert_function(const std::string& input_path, const std::string& output_path)
     {
@@ -547,7 +547,7 @@ namespace Learner
         return nullptr;
     }
 
-    static void convert(const std::string& input_path, const std::string& output_path, std::ios_base::openmode om)
+    static void convert(const std::string& input_path, const std::string& output_path, std::ios_base::openmode om, bool write_index)
     {
         if(!file_exists(input_path))
         {
@@ -558,7 +558,12 @@ namespace Learner
         auto func = get_convert_function(input_path, output_path);
         if (func != nullptr)
         {
-            func(input_path, output_path, om);
+            // Binpack chunks are encoded and decoded on up to this many threads,
+            // with a single thread sequentially, one game after the other.
+            func(input_path, output_path, om, std::max<std::size_t>(1, (std::size_t)Options["Threads"]));
+
+            if (write_index && ends_with(output_path, binpack_extension))
+                binpack::writeChunkIndex(output_path);
         }
         else
         {
@@ -566,22 +571,56 @@ namespace Learner
         }
     }
 
+    static void write_index(const std::vector<std::string>& paths)
+    {
+        for (const auto& path : paths)
+        {
+            if (!ends_with(path, binpack_extension) || !file_exists(path))
+            {
+                std::cerr << "Not a binpack file: " << path << "\n";
+                continue;
+            }
+
+            binpack::writeChunkIndex(path);
+            std::cout << "Wrote " << binpack::chunkIndexPath(path) << "\n";
+        }
+    }
+
     static void convert(const std::vector<std::string>& args)
     {
-        if (args.size() < 2 || args.size() > 3)
+        if (!args.empty() && args[0] == "index")
+        {
+            write_index(std::vector<std::string>(args.begin() + 1, args.end()));
+            return;
+        }
+
+        bool append = false;
+        bool write_index = false;
+        bool valid = args.size() >= 2;
+        for (size_t i = 2; i < args.size(); ++i)
+        {
+            if (args[i] == "append")
+                append = true;
+            else if (args[i] == "index")
+                write_index = true;
+            else
+                valid = false;
+        }
+
+        if (!valid)
         {
             std::cerr << "Invalid arguments.\n";
-            std::cerr << "Usage: convert from_path to_path [append]\n";
+            std::cerr << "Usage: convert from_path to_path [append] [index]\n";
+            std::cerr << "       convert index binpack_path...\n";
             return;
         }
 
-        const bool append = (args.size() == 3) && (args[2] == "append");
         const std::ios_base::openmode openmode =
             append
             ? std::ios_base::app
             : std::ios_base::trunc;
 
-        convert(args[0], args[1], openmode);
+        convert(args[0], args[1], openmode, write_index);
     }
 
     void convert(istringstream& is)
@@ -113,6 +113,15 @@ namespace Learner
             }
         }
 
+        // Upper bound of the write buffers, each thread fills one while
+        // the pool may hold up to about ten per thread.
+        void memory_usage(std::vector<MemoryUsage>& usage) const
+        {
+            const size_t buffers = sfen_buffers.size() + sfen_buffers_pool.capacity();
+            usage.push_back({ "Sfen writer buffers (max)", buffers * SFEN_WRITE_SIZE * sizeof(PackedSfenValue),
+                              0, buffers });
+        }
+
         // Move what remains in the buffer for your thread to a buffer for writing to a file.
         void finalize(size_t thread_id)
         {
@@ -286,6 +295,12 @@ namespace Learner
             sfen_writer.start_file_write_worker();
         }
 
+        void memory_usage(std::vector<MemoryUsage>& usage) const
+        {
+            usage.push_back({ "Gensfen duplicate hash", hash.capacity() * sizeof(Key) });
+            sfen_writer.memory_usage(usage);
+        }
+
         void thread_worker(size_t thread_id) override;
 
         optional<int8_t> get_current_game_result(
@@ -296,11 +311,19 @@ namespace Learner
 
         bool commit_psv(PSVector& a_psv, size_t thread_id, int8_t lastTurnIsWin);
 
+        bool is_random_move_ply(
+            const std::vector<uint8_t>& random_move_flag,
+            int ply,
+            int random_move_c) const;
+
         optional<Move> choose_random_move(
             Position& pos,
             std::vector<uint8_t>& random_move_flag,
             int ply,
-            int& random_move_c);
+            int& random_move_c,
+            bool multi_pv_searched);
+
+        void print_search_stats() const;
 
         // Min and max depths for search during gensfen
         int search_depth_min;
@@ -337,6 +360,12 @@ namespace Learner
         int random_multi_pv_diff;
         int random_multi_pv_depth;
 
+        // If set, a single MultiPV search gives both the score of the position
+        // and the candidates for the random move, instead of running a second
+        // search on the same position. Lines other than the best one are then
+        // only searched up to random_multi_pv_depth.
+        bool random_multi_pv_combined;
+
         // The minimum and maximum ply (number of steps from
         // the initial phase) of the sfens to write out.
         int write_minply;
@@ -346,6 +375,15 @@ namespace Learner
         SfenWriter& sfen_writer;
 
         vector<Key> hash; // 64MB*sizeof(HASH_KEY) = 512MB
+
+        // Search statistics, used to compare the cost of the random move modes.
+        // random_multi_pv_nodes counts all nodes searched on plies with a
+        // multi pv random move, separate_multi_pv_nodes only those of the
+        // second search that random_multi_pv_combined avoids.
+        std::atomic<uint64_t> nodes_searched{0};
+        std::atomic<uint64_t> random_multi_pv_plies{0};
+        std::atomic<uint64_t> random_multi_pv_nodes{0};
+        std::atomic<uint64_t> separate_multi_pv_nodes{0};
     };
 
     optional<int8_t> MultiThinkGenSfen::get_current_game_result(
@@ -424,8 +462,8 @@ namespace Learner
 
         // Draw by insufficient mating material
         if (detect_draw_by_insufficient_mating_material
-            && hasInsufficientMaterial(WHITE, pos)
-            && hasInsufficientMaterial(BLACK, pos))
+            && pos.has_insufficient_material(WHITE)
+            && pos.has_insufficient_material(BLACK))
         {
             return 0;
         }
@@ -480,20 +518,31 @@ namespace Learner
         return quit;
     }
 
+    bool MultiThinkGenSfen::is_random_move_ply(
+        const std::vector<uint8_t>& random_move_flag,
+        int ply,
+        int random_move_c) const
+    {
+        return
+            // 1. Random move of random_move_count times from random_move_minply to random_move_maxply
+            (random_move_minply != -1 && ply < (int)random_move_flag.size() && random_move_flag[ply]) ||
+            // 2. A mode to perform random move of random_move_count times after leaving the startpos
+            (random_move_minply == -1 && random_move_c < random_move_count);
+    }
+
+    // If multi_pv_searched is true, the rootMoves of the thread already
+    // hold the result of a MultiPV search of random_multi_pv lines.
     optional<Move> MultiThinkGenSfen::choose_random_move(
         Position& pos,
         std::vector<uint8_t>& random_move_flag,
         int ply,
-        int& random_move_c)
+        int& random_move_c,
+        bool multi_pv_searched)
     {
         optional<Move> random_move;
 
         // Randomly choose one from legal move
-        if (
-            // 1. Random move of random_move_count times from random_move_minply to random_move_maxply
-            (random_move_minply != -1 && ply < (int)random_move_flag.size() && random_move_flag[ply]) ||
-            // 2. A mode to perform random move of random_move_count times after leaving the startpos
-            (random_move_minply == -1 && random_move_c < random_move_count))
+        if (is_random_move_ply(random_move_flag, ply, random_move_c))
         {
             ++random_move_c;
 
@@ -546,7 +595,15 @@ namespace Learner
             }
             else
             {
-                Search::search(pos, random_multi_pv_depth, random_multi_pv);
+                if (!multi_pv_searched)
+                {
+                    Search::search(pos, random_multi_pv_depth, random_multi_pv);
+
+                    const uint64_t n = pos.this_thread()->nodes.load(std::memory_order_relaxed);
+                    nodes_searched += n;
+                    random_multi_pv_nodes += n;
+                    separate_multi_pv_nodes += n;
+                }
 
                 // Select one from the top N hands of root Moves
                 auto& rm = pos.this_thread()->rootMoves;
@@ -662,11 +719,26 @@ namespace Learner
                 // Current search depth
                 const int depth = search_depth_min + (int)prng.rand(search_depth_max - search_depth_min + 1);
 
+                // Score the position and get the random move candidates in one search if requested.
+                const bool multi_pv_ply = random_multi_pv
+                    && is_random_move_ply(random_move_flag, ply, actual_random_move_count);
+                const bool combined_search = multi_pv_ply && random_multi_pv_combined;
+
                 // Starting search calls init_for_search
-                auto [search_value, search_pv] = Search::search(pos, depth, 1, nodes);
+                auto [search_value, search_pv] = combined_search
+                    ? Search::search(pos, depth, random_multi_pv, nodes, random_multi_pv_depth)
+                    : Search::search(pos, depth, 1, nodes);
+
+                const uint64_t search_nodes = pos.this_thread()->nodes.load(std::memory_order_relaxed);
+                nodes_searched += search_nodes;
+                if (multi_pv_ply)
+                {
+                    ++random_multi_pv_plies;
+                    random_multi_pv_nodes += search_nodes;
+                }
 
                 // This has to be performed after search because it needs to know
-                // rootMoves which are filled in init_for_search.
+                // rootMoves which are filled in init_root_moves.
                 const auto result = get_current_game_result(pos, move_hist_scores);
                 if (result.has_value())
                 {
@@ -761,7 +833,7 @@ namespace Learner
                 next_move = search_pv[0];
 
                 // Random move.
-                auto random_move = choose_random_move(pos, random_move_flag, ply, actual_random_move_count);
+                auto random_move = choose_random_move(pos, random_move_flag, ply, actual_random_move_count, combined_search);
                 if (random_move.has_value())
                 {
                     next_move = random_move.value();
@@ -787,6 +859,25 @@ namespace Learner
         sfen_writer.finalize(thread_id);
     }
 
+    void MultiThinkGenSfen::print_search_stats() const
+    {
+        std::cout << "gensfen search statistics : " << endl
+            << "  nodes searched            = " << nodes_searched << endl;
+
+        if (random_multi_pv_plies)
+        {
+            std::cout
+                << "  random_multi_pv plies     = " << random_multi_pv_plies << endl
+                << "  nodes per random move ply = " << random_multi_pv_nodes / random_multi_pv_plies << endl
+                << "  separate multi pv nodes   = " << separate_multi_pv_nodes;
+
+            if (!random_multi_pv_combined)
+                std::cout << " (avoidable with random_multi_pv_combined)";
+
+            std::cout << endl;
+        }
+    }
+
     // -----------------------------------
     // Command to generate a game record (master thread)
     // -----------------------------------
@@ -823,6 +914,7 @@ namespace Learner
         int random_multi_pv = 0;
         int random_multi_pv_diff = 32000;
         int random_multi_pv_depth = INT_MIN;
+        bool random_multi_pv_combined = false;
 
         // The minimum and maximum ply (number of steps from the initial phase) of the phase to write out.
         int write_minply = 16;
@@ -880,6 +972,8 @@ namespace Learner
                 is >> random_multi_pv_diff;
             else if (token == "random_multi_pv_depth")
                 is >> random_multi_pv_depth;
+            else if (token == "random_multi_pv_combined")
+                is >> random_multi_pv_combined;
             else if (token == "write_minply")
                 is >> write_minply;
             else if (token == "write_maxply")
@@ -962,6 +1056,7 @@ namespace Learner
             << "  random_multi_pv        = " << random_multi_pv << endl
             << "  random_multi_pv_diff   = " << random_multi_pv_diff << endl
             << "  random_multi_pv_depth  = " << random_multi_pv_depth << endl
+            << "  random_multi_pv_combined = " << random_multi_pv_combined << endl
             << "  write_minply           = " << write_minply << endl
             << "  write_maxply           = " << write_maxply << endl
             << "  output_file_name       = " << output_file_name << endl
@@ -1010,10 +1105,19 @@ namespace Learner
             multi_think.random_multi_pv = random_multi_pv;
             multi_think.random_multi_pv_diff = random_multi_pv_diff;
             multi_think.random_multi_pv_depth = random_multi_pv_depth;
+            multi_think.random_multi_pv_combined = random_multi_pv_combined;
             multi_think.write_minply = write_minply;
             multi_think.write_maxply = write_maxply;
+            {
+                auto usage = UCI::memory_usage();
+                multi_think.memory_usage(usage);
+                print_memory_usage(cout, usage);
+                cout << endl;
+            }
+
             multi_think.start_file_write_worker();
             multi_think.go_think();
+            multi_think.print_search_stats();
 
             // Since we are joining with the destructor of SfenWriter, please give a message that it has finished after the join
             // Enclose this in a block because it should be displayed.
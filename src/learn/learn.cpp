@@ -19,6 +19,7 @@
 
 #include "learn.h"
 
+#include "compressed_sfen.h"
 #include "convert.h"
 #include "multi_think.h"
 #include "sfen_stream.h"
@@ -36,9 +37,12 @@
 
 #include "syzygy/tbprobe.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <climits>
 #include <cmath>    // std::exp(),std::pow(),std::log()
+#include <condition_variable>
 #include <cstring>  // memcpy()
 #include <filesystem>
 #include <fstream>
@@ -46,12 +50,13 @@
 #include <limits>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <random>
 #include <regex>
 #include <shared_mutex>
 #include <sstream>
-#include <unordered_set>
+#include <thread>
 
 #if defined (_OPENMP)
 #include <omp.h>
@@ -82,6 +87,30 @@ namespace Learner
     static bool use_draw_games_in_validation = true;
     static bool skip_duplicated_positions_in_training = true;
 
+    // Train/validation split used when no validation set file is given.
+    // A position belongs to the validation split if a keyed hash of its
+    // packed sfen is below validation_split_rate, so the split is the same
+    // across runs and files and needs neither decoding nor a set of keys.
+    static double validation_split_rate = 0.001;
+    static uint64_t validation_split_key = 0x9E3779B97F4A7C15ULL;
+
+    static uint64_t validation_split_hash(const PackedSfen& sfen)
+    {
+        static_assert(sizeof(PackedSfen) % sizeof(uint64_t) == 0);
+
+        uint64_t h = validation_split_key;
+        for (size_t i = 0; i < sizeof(PackedSfen); i += sizeof(uint64_t))
+        {
+            uint64_t w;
+            std::memcpy(&w, sfen.data + i, sizeof(w));
+            h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 31;
+        }
+
+        h *= 0x94D049BB133111EBULL;
+        return h ^ (h >> 29);
+    }
+
     static double winning_probability_coefficient = 1.0 / PawnValueEg / 4.0 * std::log(10.0);
 
     // Score scale factors. ex) If we set src_score_min_value = 0.0,
@@ -297,11 +326,11 @@ namespace Learner
         // Number of phases buffered by each thread 0.1M phases. 4M phase at 40HT
         static constexpr size_t THREAD_BUFFER_SIZE = 10 * 1000;
 
-        // Buffer for reading files (If this is made larger,
-        // the shuffle becomes larger and the phases may vary.
-        // If it is too large, the memory consumption will increase.
-        // SFEN_READ_SIZE is a multiple of THREAD_BUFFER_SIZE.
-        static constexpr const size_t SFEN_READ_SIZE = LEARN_SFEN_READ_SIZE;
+        // The positions read from the files are shuffled within a sliding
+        // window of window_size positions. The window is split into this many
+        // buckets of compressed positions, one of which is decoded, shuffled
+        // and handed to the threads at a time.
+        static constexpr size_t WINDOW_BUCKETS = 64;
 
         // hash to limit the reading of the same situation
         // Is there too many 64 million phases? Or Not really..
@@ -319,6 +348,8 @@ namespace Learner
             last_done = 0;
             next_update_weights = 0;
             save_count = 0;
+            window_size = LEARN_SFEN_READ_SIZE;
+            reader_threads = 1;
             end_of_files = false;
             no_shuffle = false;
             stop_flag = false;
@@ -332,27 +363,40 @@ namespace Learner
                 file_worker_thread.join();
         }
 
-        // Load the phase for calculation such as mse.
+        // Select the positions of the validation split with the given rate.
+        // Must be called before start_file_read_worker().
+        void set_validation_split(double rate)
+        {
+            validation_threshold = rate >= 1.0 ? UINT64_MAX
+                                 : uint64_t(std::max(rate, 0.0) * 18446744073709551616.0);
+        }
+
+        // Load the phase for calculation such as mse. The file worker sets
+        // aside the positions of the validation split, wait until it has
+        // collected enough of them or can not read any further ahead.
         void read_for_mse()
         {
-            auto th = Threads.main();
-            Position& pos = th->rootPos;
-            for (uint64_t i = 0; i < sfen_for_mse_size; ++i)
+            while (true)
             {
-                PackedSfenValue ps;
-                if (!read_to_thread_buffer(0, ps))
                 {
-                    cout << "Error! read packed sfen , failed." << endl;
-                    break;
+                    std::unique_lock<std::mutex> lk(mutex);
+                    if (validation_pool.size() >= sfen_for_mse_size)
+                        break;
                 }
 
-                sfen_for_mse.push_back(ps);
+                if (end_of_files || pool_full())
+                    break;
 
-                // Get the hash key.
-                StateInfo si;
-                pos.set_from_packed_sfen(ps.sfen, &si, th);
-                sfen_for_mse_hash.insert(pos.key());
+                sleep(1);
             }
+
+            std::unique_lock<std::mutex> lk(mutex);
+            sfen_for_mse.swap(validation_pool);
+            validation_collected = true;
+
+            if (sfen_for_mse.size() < sfen_for_mse_size)
+                cout << "Warning! only " << sfen_for_mse.size()
+                     << " positions in the validation split, consider a higher validation_split_rate." << endl;
         }
 
         void read_validation_set(const string& file_name, int eval_limit)
@@ -427,7 +471,7 @@ namespace Learner
                         packed_sfens[thread_id] = std::move(packed_sfens_pool.front());
                         packed_sfens_pool.pop_front();
 
-                        total_read += THREAD_BUFFER_SIZE;
+                        total_read += packed_sfens[thread_id]->size();
 
                         return true;
                     }
@@ -468,7 +512,8 @@ namespace Learner
                     string filename = filenames.back();
                     filenames.pop_back();
 
-                    sfen_input_stream = open_sfen_input_file(filename);
+                    // The chunk order only matters if the positions are not shuffled.
+                    sfen_input_stream = open_sfen_input_file(filename, reader_threads, no_shuffle);
                     cout << "open filename = " << filename << endl;
 
                     // in case the file is empty or was deleted.
@@ -484,80 +529,116 @@ namespace Learner
                 return;
             }
 
+            // Positions are scattered into random buckets of the window as they
+            // are read. Once the window is full, the buckets are emptied in turn,
+            // so each of them holds a random subset of the last window_size
+            // positions when it is handed out. With no_shuffle the positions are
+            // handed out in file order.
+            const size_t buckets = no_shuffle ? 1 : WINDOW_BUCKETS;
+            const size_t window = no_shuffle ? THREAD_BUFFER_SIZE : std::max(window_size, buckets);
+            vector<CompressedPSVector> window_buckets(buckets);
+            size_t window_count = 0;
+            size_t next_bucket = 0;
+
+            // Decode a bucket, shuffle it and hand it to the threads.
+            auto flush_bucket = [&](CompressedPSVector& bucket) {
+                PSVector sfens;
+                bucket.decode(sfens);
+                window_count -= bucket.size();
+                bucket.clear();
+
+                if (!no_shuffle)
+                    Algo::shuffle(sfens, prng);
+
+                std::vector<std::unique_ptr<PSVector>> buffers;
+                for (size_t i = 0; i < sfens.size(); i += THREAD_BUFFER_SIZE)
+                    buffers.emplace_back(std::make_unique<PSVector>(
+                        sfens.begin() + i, sfens.begin() + std::min(i + THREAD_BUFFER_SIZE, sfens.size())));
+
+                {
+                    std::unique_lock<std::mutex> lk(mutex);
+
+                    // The mutex lock is required because the%
+                    // contents of packed_sfens_pool are changed.
+
+                    for (auto& buf : buffers)
+                        packed_sfens_pool.emplace_back(std::move(buf));
+                }
+            };
+
             while (true)
             {
                 // Wait for the buffer to run out.
                 // This size() is read only, so you don't need to lock it.
-                while (!stop_flag && packed_sfens_pool.size() >= SFEN_READ_SIZE / THREAD_BUFFER_SIZE)
+                while (!stop_flag && pool_full())
                     sleep(100);
 
                 if (stop_flag)
                     return;
 
-                PSVector sfens;
-                sfens.reserve(SFEN_READ_SIZE);
-
-                // Read from the file into the file buffer.
-                while (sfens.size() < SFEN_READ_SIZE)
+                // Read from the file into the window until it is full.
+                while (window_count < window)
                 {
                     std::optional<PackedSfenValue> p = sfen_input_stream->next();
                     if (p.has_value())
                     {
-                        sfens.push_back(*p);
+                        // Positions of the validation split are never trained on.
+                        if (is_for_rmse(*p))
+                        {
+                            std::unique_lock<std::mutex> lk(mutex);
+                            if (!validation_collected && validation_pool.size() < sfen_for_mse_size)
+                                validation_pool.push_back(*p);
+                        }
+                        else
+                        {
+                            window_buckets[buckets > 1 ? prng.rand(buckets) : 0].push_back(*p);
+                            ++window_count;
+                        }
                     }
                     else if(!open_next_file())
                     {
-                        // There was no next file. Abort.
+                        // There was no next file. Hand out the rest and abort.
+                        for (auto& bucket : window_buckets)
+                            flush_bucket(bucket);
+
                         cout << "..end of files." << endl;
                         end_of_files = true;
                         return;
                     }
                 }
 
-                // Shuffle the read phase data.
-                if (!no_shuffle)
-                {
-                    Algo::shuffle(sfens, prng);
-                }
-
-                // Divide this by THREAD_BUFFER_SIZE. There should be size pieces.
-                // SFEN_READ_SIZE shall be a multiple of THREAD_BUFFER_SIZE.
-                assert((SFEN_READ_SIZE % THREAD_BUFFER_SIZE) == 0);
-
-                auto size = size_t(SFEN_READ_SIZE / THREAD_BUFFER_SIZE);
-                std::vector<std::unique_ptr<PSVector>> buffers;
-                buffers.reserve(size);
-
-                for (size_t i = 0; i < size; ++i)
-                {
-                    // Delete this pointer on the receiving side.
-                    auto buf = std::make_unique<PSVector>();
-                    buf->resize(THREAD_BUFFER_SIZE);
-                    memcpy(
-                        buf->data(),
-                        &sfens[i * THREAD_BUFFER_SIZE],
-                        sizeof(PackedSfenValue) * THREAD_BUFFER_SIZE);
-
-                    buffers.emplace_back(std::move(buf));
-                }
-
-                {
-                    std::unique_lock<std::mutex> lk(mutex);
+                flush_bucket(window_buckets[next_bucket]);
+                next_bucket = (next_bucket + 1) % buckets;
+            }
+        }
 
-                    // The mutex lock is required because the%
-                    // contents of packed_sfens_pool are changed.
+        // Whether enough decoded positions are waiting for the threads
+        bool pool_full() const
+        {
+            const size_t bucket_buffers = window_size / WINDOW_BUCKETS / THREAD_BUFFER_SIZE + 1;
+            return packed_sfens_pool.size() >= std::max(2 * bucket_buffers, packed_sfens.size());
+        }
 
-                    for (auto& buf : buffers)
-                        packed_sfens_pool.emplace_back(std::move(buf));
-                }
-            }
+        // Upper bounds of the memory used by the reader once the shuffle
+        // window and the buffer pool have been filled.
+        void memory_usage(std::vector<MemoryUsage>& usage) const
+        {
+            const size_t buffer_bytes = THREAD_BUFFER_SIZE * sizeof(PackedSfenValue);
+            const size_t bucket_buffers = window_size / WINDOW_BUCKETS / THREAD_BUFFER_SIZE + 1;
+            const size_t window = no_shuffle ? THREAD_BUFFER_SIZE : window_size;
+
+            usage.push_back({ "Sfen reader duplicate hash", hash.capacity() * sizeof(Key) });
+            usage.push_back({ "Sfen reader shuffle window (max)", window * CompressedPSVector::MaxEntrySize });
+            const size_t buffers = std::max(2 * bucket_buffers, packed_sfens.size()) + packed_sfens.size();
+            usage.push_back({ "Sfen reader decoded buffers (max)", buffers * buffer_bytes, 0, buffers });
+            usage.push_back({ "Sfen reader validation positions", sfen_for_mse.capacity() * sizeof(PackedSfenValue) });
         }
 
         // Determine if it is a phase for calculating rmse.
         // (The computational aspects of rmse should not be used for learning.)
-        bool is_for_rmse(Key key) const
+        bool is_for_rmse(const PackedSfenValue& ps) const
         {
-            return sfen_for_mse_hash.count(key) != 0;
+            return validation_split_hash(ps.sfen) < validation_threshold;
         }
 
         // sfen files
@@ -580,6 +661,12 @@ namespace Learner
         // Do not shuffle when reading the phase.
         bool no_shuffle;
 
+        // Number of positions in the shuffle window
+        size_t window_size;
+
+        // Number of threads decoding .binpack chunks
+        size_t reader_threads;
+
         std::atomic<bool> stop_flag;
 
         vector<Key> hash;
@@ -613,8 +700,14 @@ namespace Learner
         // * Lock and access the mutex.
         std::list<std::unique_ptr<PSVector>> packed_sfens_pool;
 
-        // Hold the hash key so that the mse calculation phase is not used for learning.
-        std::unordered_set<Key> sfen_for_mse_hash;
+        // Positions with a validation split hash below this are used for the
+        // mse calculation instead of learning. 0 disables the split.
+        uint64_t validation_threshold = 0;
+
+        // Validation split positions set aside by the file worker until
+        // read_for_mse() takes them. * Lock and access the mutex.
+        PSVector validation_pool;
+        bool validation_collected = false;
     };
 
     // Class to generate sfen with multiple threads
@@ -1446,39 +1539,179 @@ namespace Learner
     }
 
     // Subcontracting the teacher shuffle "learn shufflem" command.
-    // Read the whole memory and write it out with the specified file name.
-    void shuffle_files_on_memory(const vector<string>& filenames, const string output_file_name, const std::string& seed)
+    // Read everything into memory and write it out with the specified file name.
+    //
+    // The work is split over thread_num threads. While reading, every position
+    // is scattered into one of several partitions chosen uniformly at random,
+    // then the partitions are shuffled independently. Concatenating the shuffled
+    // partitions gives a uniform random permutation of the whole input, so the
+    // output can be streamed partition by partition while later ones are still
+    // being shuffled, and each partition is freed as soon as it is written.
+    // The output is written in .binpack format if output_file_name has that
+    // extension and in .bin format otherwise. Inputs may be .bin or .binpack.
+    // Since the scatter order depends on thread timing, the result is not
+    // reproducible from the seed alone.
+    void shuffle_files_on_memory(const vector<string>& filenames, const string output_file_name, const std::string& seed, int thread_num)
     {
-        PSVector buf;
+        // A piece of input that is read by a single thread. .bin files are
+        // split into ranges of positions, .binpack files into ranges of chunks.
+        struct ReadTask {
+            string filename;
+            uint64_t offset;
+            uint64_t count;
+            vector<binpack::ChunkLocation> chunks;
+        };
+
+        constexpr uint64_t ReadTaskSize = 1024 * 1024; // positions
+        constexpr size_t ReadTaskChunks = 16;          // binpack chunks of up to 1MB
+        constexpr size_t FlushSize = 256;              // positions per partition and thread
+
+        const size_t threads = std::max(thread_num, 1);
+        const size_t partitions = threads * 4;
 
+        // Progress is printed here, since the worker threads would interleave
+        // their output.
+        vector<ReadTask> tasks;
         for (auto filename : filenames)
         {
-            std::cout << "read : " << filename << std::endl;
-            read_file_to_memory(filename, [&buf](uint64_t size) {
-                assert((size % sizeof(PackedSfenValue)) == 0);
-                // Expand the buffer and read after the last end.
-                uint64_t last = buf.size();
-                buf.resize(last + size / sizeof(PackedSfenValue));
-                return (void*)&buf[last];
-                });
+            cout << "read : " << filename << endl;
+
+            if (has_extension(filename, BinSfenInputStream::extension))
+            {
+                fstream fs(filename, ios::in | ios::binary);
+                if (fs.fail())
+                {
+                    cout << "Error! : can't read " << filename << endl;
+                    continue;
+                }
+
+                const uint64_t size = get_file_size(fs) / sizeof(PackedSfenValue);
+                for (uint64_t offset = 0; offset < size; offset += ReadTaskSize)
+                    tasks.push_back({ filename, offset, std::min(ReadTaskSize, size - offset), {} });
+            }
+            else if (has_extension(filename, BinpackSfenInputStream::extension))
+            {
+                // Uses the .index file written by "convert" if there is one.
+                const auto chunks = binpack::chunkLocations(filename);
+                for (size_t i = 0; i < chunks.size(); i += ReadTaskChunks)
+                    tasks.push_back({ filename, 0, 0, vector<binpack::ChunkLocation>(
+                        chunks.begin() + i, chunks.begin() + std::min(i + ReadTaskChunks, chunks.size())) });
+            }
+            else
+                cout << "Error! : unknown file format " << filename << endl;
         }
 
-        // shuffle from buf[0] to buf[size-1]
         // Do not use std::random_device().  Because it always the same integers on MinGW.
         PRNG prng(seed);
-        uint64_t size = (uint64_t)buf.size();
-        std::cout << "shuffle buf.size() = " << size << std::endl;
+        vector<uint64_t> seeds(threads + partitions);
+        for (auto& s : seeds)
+            s = prng.rand<uint64_t>() | 1;
+
+        vector<PSVector> buf(partitions);
+        vector<std::mutex> buf_mutex(partitions);
+        std::atomic<size_t> next_task(0);
+
+        auto scatter_worker = [&](size_t thread_id) {
+            PRNG thread_prng(seeds[thread_id]);
+            vector<PSVector> local(partitions);
+
+            auto flush = [&](size_t p) {
+                std::unique_lock<std::mutex> lk(buf_mutex[p]);
+                buf[p].insert(buf[p].end(), local[p].begin(), local[p].end());
+                lk.unlock();
+                local[p].clear();
+            };
 
-        Algo::shuffle(buf, prng);
+            auto scatter = [&](const PackedSfenValue& psv) {
+                const size_t p = thread_prng.rand(partitions);
+                local[p].push_back(psv);
+                if (local[p].size() >= FlushSize)
+                    flush(p);
+            };
 
-        std::cout << "write : " << output_file_name << endl;
+            for (size_t i; (i = next_task++) < tasks.size(); )
+            {
+                const ReadTask& task = tasks[i];
+                if (task.count)
+                {
+                    PSVector chunk(task.count);
+                    fstream fs(task.filename, ios::in | ios::binary);
+                    fs.seekg(task.offset * sizeof(PackedSfenValue));
+                    fs.read(reinterpret_cast<char*>(chunk.data()), task.count * sizeof(PackedSfenValue));
+                    for (auto& psv : chunk)
+                        scatter(psv);
+                }
+                else
+                {
+                    BinpackSfenInputStream in(task.filename, task.chunks);
+                    while (auto psv = in.next())
+                        scatter(*psv);
+                }
+            }
 
-        // If the file to be written exceeds 2GB, it cannot be
-        // written in one shot with fstream::write, so use wrapper.
-        write_memory_to_file(
-            output_file_name,
-            (void*)&buf[0],
-            sizeof(PackedSfenValue) * buf.size());
+            for (size_t p = 0; p < partitions; ++p)
+                flush(p);
+        };
+
+        cout << "read " << filenames.size() << " files with " << threads << " threads.." << endl;
+
+        vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back(scatter_worker, t);
+        for (auto& th : workers)
+            th.join();
+        workers.clear();
+
+        uint64_t size = 0;
+        for (auto& b : buf)
+            size += b.size();
+        cout << "shuffle buf.size() = " << size << " in " << partitions << " partitions" << endl;
+
+        // Shuffle the partitions in parallel and write them out in order as
+        // soon as they are done.
+        vector<bool> shuffled(partitions, false);
+        std::mutex shuffled_mutex;
+        std::condition_variable shuffled_cv;
+        std::atomic<size_t> next_partition(0);
+
+        auto shuffle_worker = [&]() {
+            for (size_t p; (p = next_partition++) < partitions; )
+            {
+                PRNG partition_prng(seeds[threads + p]);
+                Algo::shuffle(buf[p], partition_prng);
+
+                std::lock_guard<std::mutex> lk(shuffled_mutex);
+                shuffled[p] = true;
+                shuffled_cv.notify_one();
+            }
+        };
+
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back(shuffle_worker);
+
+        const auto sfen_output_type = has_extension(output_file_name, BinpackSfenOutputStream::extension)
+                                    ? SfenOutputType::Binpack : SfenOutputType::Bin;
+
+        cout << "write : " << output_file_name << endl;
+
+        // The output streams append, so start from an empty file.
+        std::remove(output_file_name.c_str());
+        {
+            auto out = create_new_sfen_output(output_file_name, sfen_output_type, threads);
+
+            for (size_t p = 0; p < partitions; ++p)
+            {
+                std::unique_lock<std::mutex> lk(shuffled_mutex);
+                shuffled_cv.wait(lk, [&] { return bool(shuffled[p]); });
+                lk.unlock();
+
+                out->write(buf[p]);
+                PSVector().swap(buf[p]);
+            }
+        }
+
+        for (auto& th : workers)
+            th.join();
 
         std::cout << "..shuffle_on_memory done." << std::endl;
     }
@@ -1562,6 +1795,10 @@ namespace Learner
         // Turn on if you want to pass a pre-shuffled file.
         bool no_shuffle = false;
 
+        // Number of positions in the shuffle window of the reader.
+        uint64_t read_window_size = LEARN_SFEN_READ_SIZE;
+        uint64_t reader_threads = 1;
+
         global_learning_rate = 1.0;
 
         // elmo lambda
@@ -1655,6 +1892,8 @@ namespace Learner
             else if (option == "eval_limit") is >> eval_limit;
             else if (option == "save_only_once") save_only_once = true;
             else if (option == "no_shuffle") no_shuffle = true;
+            else if (option == "read_window_size") is >> read_window_size;
+            else if (option == "reader_threads") is >> reader_threads;
 
             else if (option == "nn_batch_size") is >> nn_batch_size;
             else if (option == "newbob_decay") is >> newbob_decay;
@@ -1665,6 +1904,8 @@ namespace Learner
             else if (option == "eval_save_interval") is >> eval_save_interval;
             else if (option == "loss_output_interval") is >> loss_output_interval;
             else if (option == "validation_set_file_name") is >> validation_set_file_name;
+            else if (option == "validation_split_rate") is >> validation_split_rate;
+            else if (option == "validation_split_key") is >> validation_split_key;
 
             // Rabbit convert related
             else if (option == "convert_plain") use_convert_plain = true;
@@ -1734,6 +1975,11 @@ namespace Learner
         {
             cout << "validation set  : " << validation_set_file_name << endl;
         }
+        else
+        {
+            cout << "validation split: rate " << validation_split_rate
+                 << " , key " << validation_split_key << endl;
+        }
 
         cout << "base dir        : " << base_dir << endl;
         cout << "target dir      : " << target_dir << endl;
@@ -1757,7 +2003,7 @@ namespace Learner
         if (shuffle_on_memory)
         {
             cout << "shuffle on memory.." << endl;
-            shuffle_files_on_memory(filenames, output_file_name, seed);
+            shuffle_files_on_memory(filenames, output_file_name, seed, thread_num);
             return;
         }
 
@@ -1807,6 +2053,8 @@ namespace Learner
         cout << "eval_limit        : " << eval_limit << endl;
         cout << "save_only_once    : " << (save_only_once ? "true" : "false") << endl;
         cout << "no_shuffle        : " << (no_shuffle ? "true" : "false") << endl;
+        cout << "read_window_size  : " << read_window_size << endl;
+        cout << "reader_threads    : " << reader_threads << endl;
 
         // Insert the file name for the number of loops.
         for (int i = 0; i < loop; ++i)
@@ -1878,6 +2126,8 @@ namespace Learner
         learn_think.eval_limit = eval_limit;
         learn_think.save_only_once = save_only_once;
         learn_think.sr.no_shuffle = no_shuffle;
+        learn_think.sr.window_size = read_window_size;
+        learn_think.sr.reader_threads = reader_threads;
         learn_think.reduction_gameply = reduction_gameply;
 
         learn_think.newbob_decay = newbob_decay;
@@ -1887,6 +2137,9 @@ namespace Learner
         learn_think.eval_save_interval = eval_save_interval;
         learn_think.loss_output_interval = loss_output_interval;
 
+        if (validation_set_file_name.empty())
+            sr.set_validation_split(validation_split_rate);
+
         // Start a thread that loads the phase file in the background
         // (If this is not started, mse cannot be calculated.)
         learn_think.start_file_read_worker();
@@ -1924,6 +2177,14 @@ namespace Learner
         // -----------------------------------
 
         // Start learning.
+        {
+            auto usage = UCI::memory_usage();
+            learn_think.sr.memory_usage(usage);
+            Eval::NNUE::learner_memory_usage(usage);
+            print_memory_usage(cout, usage);
+            cout << endl;
+        }
+
         learn_think.go_think();
 
         Eval::NNUE::finalize_net();
@@ -1932,4 +2193,173 @@ namespace Learner
         learn_think.save(true);
     }
 
+    // Compare the validation loss of several nets on the same data.
+    // Example: validate eval_dir evalsave net nn-old.bin validation_set_file_name val.binpack
+    // All nets are loaded concurrently into separate instances. Each position
+    // is then decoded once and evaluated statically by every net, so comparing
+    // K nets costs a single pass over the data.
+    void validate(std::istringstream& is)
+    {
+        vector<string> net_file_names;
+        string validation_set_file_name;
+        uint64_t max_positions = UINT64_MAX;
+        int eval_limit = 32000;
+
+        ELMO_LAMBDA = 1.0;
+        ELMO_LAMBDA2 = 1.0;
+        ELMO_LAMBDA_LIMIT = 32000;
+
+        string option;
+        while (is >> option)
+        {
+            if (option == "net")
+            {
+                is >> option;
+                net_file_names.push_back(option);
+            }
+            // All nets saved by learn, i.e. <eval_dir>/*/nn.bin
+            else if (option == "eval_dir")
+            {
+                string eval_dir;
+                is >> eval_dir;
+
+                namespace sys = std::filesystem;
+                vector<string> dirs;
+                for (const auto& entry : sys::directory_iterator(eval_dir))
+                    if (sys::is_regular_file(entry.path() / "nn.bin"))
+                        dirs.push_back((entry.path() / "nn.bin").generic_string());
+
+                std::sort(dirs.begin(), dirs.end());
+                net_file_names.insert(net_file_names.end(), dirs.begin(), dirs.end());
+            }
+            else if (option == "validation_set_file_name") is >> validation_set_file_name;
+            else if (option == "max_positions") is >> max_positions;
+            else if (option == "eval_limit") is >> eval_limit;
+            else if (option == "use_draw_in_validation"
+                  || option == "use_draw_games_in_validation")
+                is >> use_draw_games_in_validation;
+            else if (option == "lambda")       is >> ELMO_LAMBDA;
+            else if (option == "lambda2")      is >> ELMO_LAMBDA2;
+            else if (option == "lambda_limit") is >> ELMO_LAMBDA_LIMIT;
+            else
+                cout << "Error! : Illegal token " << option << endl;
+        }
+
+        if (net_file_names.empty() || validation_set_file_name.empty())
+        {
+            cout << "Error! : validate needs at least one net and validation_set_file_name." << endl;
+            return;
+        }
+
+        const size_t net_count = net_file_names.size();
+        vector<Eval::NNUE::Net> nets(net_count);
+        vector<char> loaded(net_count, false);
+
+        cout << "loading " << net_count << " nets.." << endl;
+
+        vector<std::thread> loaders;
+        for (size_t i = 0; i < net_count; ++i)
+            loaders.emplace_back([&, i] {
+                std::ifstream stream(net_file_names[i], std::ios::binary);
+                loaded[i] = Eval::NNUE::load_net(nets[i], stream);
+            });
+
+        for (auto& th : loaders)
+            th.join();
+
+        for (size_t i = 0; i < net_count; ++i)
+            if (!loaded[i])
+            {
+                cout << "Error! : failed to load " << net_file_names[i] << endl;
+                return;
+            }
+
+        PSVector psvs;
+        auto input = open_sfen_input_file(validation_set_file_name);
+        while (psvs.size() < max_positions)
+        {
+            std::optional<PackedSfenValue> p = input->next();
+            if (!p.has_value())
+                break;
+
+            if (eval_limit < abs(p->score))
+                continue;
+
+            if (!use_draw_games_in_validation && p->game_result == 0)
+                continue;
+
+            psvs.push_back(*p);
+        }
+
+        cout << "validate on " << psvs.size() << " positions from " << validation_set_file_name << endl;
+
+        // Loss sums of each net, accumulated per thread and summed up at the end.
+        struct LossSum {
+            double loss = 0, cross_entropy_eval = 0, cross_entropy_win = 0, norm = 0;
+        };
+
+        vector<vector<LossSum>> thread_sums(Threads.size(), vector<LossSum>(net_count));
+        std::atomic<uint64_t> next_position(0);
+
+        Threads.execute_with_workers([&](Thread& th) {
+            auto& sums = thread_sums[th.thread_idx()];
+            Position& pos = th.rootPos;
+
+            for (uint64_t i; (i = next_position++) < psvs.size(); )
+            {
+                const PackedSfenValue& ps = psvs[i];
+
+                StateInfo si;
+                if (pos.set_from_packed_sfen(ps.sfen, &si, &th) != 0)
+                {
+                    cout << "Error! : illegal packed sfen " << pos.fen() << endl;
+                    continue;
+                }
+
+                for (size_t n = 0; n < net_count; ++n)
+                {
+                    const Value shallow_value = Eval::NNUE::evaluate(pos, nets[n]);
+
+                    double cross_entropy_eval, cross_entropy_win, cross_entropy;
+                    double entropy_eval, entropy_win, entropy;
+                    calc_cross_entropy(
+                        (Value)ps.score,
+                        shallow_value,
+                        ps,
+                        cross_entropy_eval,
+                        cross_entropy_win,
+                        cross_entropy,
+                        entropy_eval,
+                        entropy_win,
+                        entropy);
+
+                    sums[n].loss += cross_entropy - entropy;
+                    sums[n].cross_entropy_eval += cross_entropy_eval;
+                    sums[n].cross_entropy_win += cross_entropy_win;
+                    sums[n].norm += abs(shallow_value);
+                }
+            }
+        });
+        Threads.wait_for_workers_finished();
+
+        const double count = std::max<double>(psvs.size(), 1);
+        for (size_t n = 0; n < net_count; ++n)
+        {
+            LossSum total;
+            for (const auto& sums : thread_sums)
+            {
+                total.loss += sums[n].loss;
+                total.cross_entropy_eval += sums[n].cross_entropy_eval;
+                total.cross_entropy_win += sums[n].cross_entropy_win;
+                total.norm += sums[n].norm;
+            }
+
+            cout << net_file_names[n]
+                 << " : loss = " << total.loss / count
+                 << " , test_cross_entropy_eval = " << total.cross_entropy_eval / count
+                 << " , test_cross_entropy_win = " << total.cross_entropy_win / count
+                 << " , norm = " << total.norm << endl;
+        }
+    }
+
 } // namespace Learner
@@ -54,9 +54,9 @@ namespace Learner
 
     constexpr std::size_t LEARN_MINI_BATCH_SIZE = 1000 * 1000 * 1;
 
-    // The number of phases to read from the file at one time. After reading this much, shuffle.
-    // It is better to have a certain size, but this number x 40 bytes x 3 times as much memory is consumed. 400MB*3 is consumed in the 10M phase.
-    // Must be a multiple of THREAD_BUFFER_SIZE(=10000).
+    // Default size of the window in which the read phases are shuffled.
+    // It is better to have a certain size. The window is stored compressed,
+    // which takes about 30 bytes per phase, i.e. about 300MB for the 10M phase.
 
     constexpr std::size_t LEARN_SFEN_READ_SIZE = 1000 * 1000 * 10;
 
@@ -74,6 +74,9 @@ namespace Learner
 
     // Learning from the generated game record
     void learn(Position& pos, std::istringstream& is);
+
+    // Compare the validation loss of several nets in one pass over the data
+    void validate(std::istringstream& is);
 }
 
 #endif // ifndef _LEARN_H_
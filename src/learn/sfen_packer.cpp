@@ -286,6 +286,7 @@ namespace Learner {
         std::memset(si, 0, sizeof(StateInfo));
         pos.st = si;
         pos.var = variants.find(Options["UCI_Variant"])->second;
+        pos.psqt = &pos.var->psqt();
 
         // Active color
         pos.sideToMove = (Color)stream.read_one_bit();
@@ -91,9 +91,24 @@ namespace Learner {
         static constexpr auto openmode = std::ios::in | std::ios::binary;
         static inline const std::string extension = "binpack";
 
-        BinpackSfenInputStream(std::string filename) :
-            m_stream(filename, openmode),
-            m_eof(!m_stream.hasNext())
+        // With more than one thread, chunks are decoded on num_threads threads
+        // and, without keep_order, returned in the order they finish decoding.
+        // A single thread reads the file sequentially, without first locating
+        // all chunks.
+        BinpackSfenInputStream(std::string filename, size_t num_threads = 1, bool keep_order = true)
+        {
+            if (num_threads > 1)
+                m_parallel_stream = std::make_unique<binpack::CompressedTrainingDataEntryParallelReader>(filename, num_threads, keep_order);
+            else
+                m_stream = std::make_unique<binpack::CompressedTrainingDataEntryReader>(filename, openmode);
+
+            m_eof = !has_next();
+        }
+
+        // Only read the given chunks of the file.
+        BinpackSfenInputStream(std::string filename, std::vector<binpack::ChunkLocation> chunks, size_t num_threads = 1, bool keep_order = true) :
+            m_parallel_stream(std::make_unique<binpack::CompressedTrainingDataEntryParallelReader>(filename, std::move(chunks), num_threads, keep_order)),
+            m_eof(!has_next())
         {
         }
 
@@ -101,13 +116,13 @@ namespace Learner {
         {
             static_assert(sizeof(binpack::nodchip::PackedSfenValue) == sizeof(PackedSfenValue));
 
-            if (!m_stream.hasNext())
+            if (!has_next())
             {
                 m_eof = true;
                 return std::nullopt;
             }
 
-            auto training_data_entry = m_stream.next();
+            auto training_data_entry = m_stream ? m_stream->next() : m_parallel_stream->next();
             auto v = binpack::trainingDataEntryToPackedSfenValue(training_data_entry);
             PackedSfenValue psv;
             // same layout, different types. One is from generic library.
@@ -124,7 +139,13 @@ namespace Learner {
         ~BinpackSfenInputStream() override {}
 
     private:
-        binpack::CompressedTrainingDataEntryReader m_stream;
+        bool has_next()
+        {
+            return m_stream ? m_stream->hasNext() : m_parallel_stream->hasNext();
+        }
+
+        std::unique_ptr<binpack::CompressedTrainingDataEntryReader> m_stream;
+        std::unique_ptr<binpack::CompressedTrainingDataEntryParallelReader> m_parallel_stream;
         bool m_eof;
     };
 
@@ -160,9 +181,17 @@ namespace Learner {
         static constexpr auto openmode = std::ios::out | std::ios::binary | std::ios::app;
         static inline const std::string extension = "binpack";
 
-        BinpackSfenOutputStream(std::string filename) :
-            m_stream(filename_with_extension(filename, extension), openmode)
+        // With more than one thread, batches of positions are encoded on up to
+        // num_threads threads. A game spanning two batches is then stored as two
+        // move chains. A single thread encodes the positions as they come.
+        BinpackSfenOutputStream(std::string filename, size_t num_threads = 1)
         {
+            if (num_threads > 1)
+                m_parallel_stream = std::make_unique<binpack::CompressedTrainingDataEntryParallelWriter>(
+                    filename_with_extension(filename, extension), num_threads, openmode);
+            else
+                m_stream = std::make_unique<binpack::CompressedTrainingDataEntryWriter>(
+                    filename_with_extension(filename, extension), openmode);
         }
 
         void write(const PSVector& sfens) override
@@ -174,35 +203,39 @@ namespace Learner {
                 // The library uses a type that's different but layout-compatibile.
                 binpack::nodchip::PackedSfenValue e;
                 std::memcpy(&e, &sfen, sizeof(binpack::nodchip::PackedSfenValue));
-                m_stream.addTrainingDataEntry(binpack::packedSfenValueToTrainingDataEntry(e));
+                if (m_stream)
+                    m_stream->addTrainingDataEntry(binpack::packedSfenValueToTrainingDataEntry(e));
+                else
+                    m_parallel_stream->addTrainingDataEntry(binpack::packedSfenValueToTrainingDataEntry(e));
             }
         }
 
         ~BinpackSfenOutputStream() override {}
 
     private:
-        binpack::CompressedTrainingDataEntryWriter m_stream;
+        std::unique_ptr<binpack::CompressedTrainingDataEntryWriter> m_stream;
+        std::unique_ptr<binpack::CompressedTrainingDataEntryParallelWriter> m_parallel_stream;
     };
 
-    inline std::unique_ptr<BasicSfenInputStream> open_sfen_input_file(const std::string& filename)
+    inline std::unique_ptr<BasicSfenInputStream> open_sfen_input_file(const std::string& filename, size_t num_threads = 1, bool keep_order = true)
     {
         if (has_extension(filename, BinSfenInputStream::extension))
             return std::make_unique<BinSfenInputStream>(filename);
         else if (has_extension(filename, BinpackSfenInputStream::extension))
-            return std::make_unique<BinpackSfenInputStream>(filename);
+            return std::make_unique<BinpackSfenInputStream>(filename, num_threads, keep_order);
 
         assert(false);
         return nullptr;
     }
 
-    inline std::unique_ptr<BasicSfenOutputStream> create_new_sfen_output(const std::string& filename, SfenOutputType sfen_output_type)
+    inline std::unique_ptr<BasicSfenOutputStream> create_new_sfen_output(const std::string& filename, SfenOutputType sfen_output_type, size_t num_threads = 1)
     {
         switch(sfen_output_type)
         {
             case SfenOutputType::Bin:
                 return std::make_unique<BinSfenOutputStream>(filename);
             case SfenOutputType::Binpack:
-                return std::make_unique<BinpackSfenOutputStream>(filename);
+                return std::make_unique<BinpackSfenOutputStream>(filename, num_threads);
         }
 
         assert(false);
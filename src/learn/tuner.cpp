@@ -0,0 +1,534 @@
+// Texel-style tuner for the classical evaluation.
+//
+// Tunes the parameters registered with TUNE() (see tune.h) on quiet positions
+// from .bin, .binpack or .plain training data. The loss is the mean squared
+// error between sigmoid(K * eval) and the game result, optionally mixed with
+// the teacher score.
+//
+// The classical evaluation is not differentiable, so each epoch linearizes it
+// around the current parameters: the derivative of every position's eval with
+// respect to every parameter is taken by central differences, one parameter at
+// a time, with all threads evaluating their share of the positions. The
+// optimizer then runs Adam on this linear model, each thread accumulating the
+// gradient of its positions. At the end of an epoch the rounded parameters are
+// applied and the true loss is measured, which also decides whether the step is
+// kept.
+
+#include "tuner.h"
+
+#include "packed_sfen.h"
+#include "sfen_stream.h"
+
+#include "evaluate.h"
+#include "misc.h"
+#include "movegen.h"
+#include "position.h"
+#include "search.h"
+#include "thread.h"
+#include "uci.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace Learner
+{
+    namespace {
+
+        // A parameter under tuning, i.e. one of the UCI options created by
+        // Tune::init(). A Score parameter gives two of them.
+        struct Param
+        {
+            string name;
+            int min, max;
+
+            // Value the current coefficients were taken at
+            int value;
+
+            // Value of the optimizer and its Adam moments
+            double x, m = 0.0, v = 0.0;
+        };
+
+        // Quiet position with its target winning probability for the side to move
+        struct Entry
+        {
+            PackedSfen sfen;
+            float target;
+        };
+
+        // Derivative of the eval of a position with respect to one parameter.
+        // The index is relative to the first position of the thread.
+        struct Coefficient
+        {
+            uint32_t index;
+            float value;
+        };
+
+        // Each thread always handles the same contiguous range of positions,
+        // so everything it stores per position needs no locking.
+        pair<size_t, size_t> thread_range(size_t count, size_t thread_idx)
+        {
+            const size_t threads = Threads.size();
+            return { count * thread_idx / threads, count * (thread_idx + 1) / threads };
+        }
+
+        void set_param(const Param& p, int value)
+        {
+            Options[p.name] = std::to_string(value);
+            Tune::read_options();
+        }
+
+        // Evaluate all positions with the current parameters and call
+        // f(thread_idx, index, value) with the static eval for the side to move.
+        template<typename F>
+        void evaluate_all(const vector<Entry>& entries, F f)
+        {
+            Threads.execute_with_workers([&](Thread& th) {
+                // Cached pawn and material entries depend on the parameters
+                th.clear_tables();
+                th.contempt = SCORE_ZERO;
+
+                Position& pos = th.rootPos;
+                StateInfo si;
+
+                const auto [begin, end] = thread_range(entries.size(), th.thread_idx());
+                for (size_t i = begin; i < end; ++i)
+                {
+                    pos.set_from_packed_sfen(entries[i].sfen, &si, &th);
+                    f(th.thread_idx(), i, Eval::evaluate(pos));
+                }
+            });
+            Threads.wait_for_workers_finished();
+        }
+
+        double mean_squared_error(const vector<Entry>& entries, const vector<double>& evals, double k)
+        {
+            double sum = 0.0;
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const double r = Math::sigmoid(k * evals[i]) - entries[i].target;
+                sum += r * r;
+            }
+
+            return sum / std::max<size_t>(entries.size(), 1);
+        }
+
+        // Golden section search for the scale K of the sigmoid that fits the
+        // current evals best.
+        double fit_k(const vector<Entry>& entries, const vector<double>& evals)
+        {
+            const double phi = (std::sqrt(5.0) - 1.0) / 2.0;
+            double a = 0.0, b = 0.05;
+            double c = b - phi * (b - a), d = a + phi * (b - a);
+            double fc = mean_squared_error(entries, evals, c);
+            double fd = mean_squared_error(entries, evals, d);
+
+            for (int i = 0; i < 60; ++i)
+            {
+                if (fc < fd)
+                {
+                    b = d, d = c, fd = fc;
+                    c = b - phi * (b - a);
+                    fc = mean_squared_error(entries, evals, c);
+                }
+                else
+                {
+                    a = c, c = d, fc = fd;
+                    d = a + phi * (b - a);
+                    fd = mean_squared_error(entries, evals, d);
+                }
+            }
+
+            return (a + b) / 2;
+        }
+
+        // Positions of a .plain file, i.e. "fen/move/score/ply/result/e" records
+        void read_plain(Position& pos, const string& filename, PSVector& psvs, uint64_t max_positions)
+        {
+            std::ifstream ifs(filename);
+            if (!ifs)
+            {
+                cout << "Error! : can't open " << filename << endl;
+                return;
+            }
+
+            Position tpos;
+            StateInfo si;
+            PackedSfenValue p{};
+            string line, token;
+
+            while (psvs.size() < max_positions && std::getline(ifs, line))
+            {
+                istringstream ss(line);
+                ss >> token;
+
+                if (token == "fen")
+                {
+                    tpos.set(pos.variant(), line.substr(4), pos.is_chess960(), &si, Threads.main());
+                    tpos.sfen_pack(p.sfen);
+                }
+                else if (token == "score")
+                {
+                    int score;
+                    ss >> score;
+                    p.score = int16_t(score);
+                }
+                else if (token == "ply")
+                {
+                    int ply;
+                    ss >> ply;
+                    p.gamePly = uint16_t(ply);
+                }
+                else if (token == "result")
+                {
+                    int result;
+                    ss >> result;
+                    p.game_result = int8_t(result);
+                }
+                else if (token == "e")
+                    psvs.push_back(p);
+            }
+        }
+
+        PSVector read_positions(Position& pos, const vector<string>& filenames, uint64_t max_positions)
+        {
+            PSVector psvs;
+
+            for (const auto& filename : filenames)
+            {
+                cout << "reading " << filename << endl;
+
+                if (has_extension(filename, "plain"))
+                {
+                    read_plain(pos, filename, psvs, max_positions);
+                    continue;
+                }
+
+                if (   !has_extension(filename, BinSfenInputStream::extension)
+                    && !has_extension(filename, BinpackSfenInputStream::extension))
+                {
+                    cout << "Error! : unknown format of " << filename << endl;
+                    continue;
+                }
+
+                auto input = open_sfen_input_file(filename, Threads.size());
+                while (psvs.size() < max_positions)
+                {
+                    std::optional<PackedSfenValue> p = input->next();
+                    if (!p.has_value())
+                        break;
+
+                    psvs.push_back(*p);
+                }
+            }
+
+            return psvs;
+        }
+
+        // Replace each position by the leaf of its qsearch PV, so that the
+        // static eval is not dominated by pending captures. Positions in check
+        // and game ends are dropped.
+        vector<Entry> quiet_entries(const PSVector& psvs, double lambda, int eval_limit, bool use_draw_games)
+        {
+            vector<Entry> entries(psvs.size());
+            vector<char> valid(psvs.size(), false);
+
+            // Teacher scores are converted with the usual win rate model
+            const double score_k = std::log(10.0) / (4.0 * int(PawnValueEg));
+
+            Threads.execute_with_workers([&](Thread& th) {
+                Position& pos = th.rootPos;
+                StateInfo si, states[MAX_PLY];
+
+                const auto [begin, end] = thread_range(psvs.size(), th.thread_idx());
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const PackedSfenValue& ps = psvs[i];
+
+                    if (   abs(ps.score) > eval_limit
+                        || (!use_draw_games && ps.game_result == 0))
+                        continue;
+
+                    if (   pos.set_from_packed_sfen(ps.sfen, &si, &th) != 0
+                        || pos.checkers()
+                        || MoveList<LEGAL>(pos).size() == 0)
+                        continue;
+
+                    const auto [_, pv] = Search::qsearch(pos);
+
+                    int ply = 0;
+                    for (Move m : pv)
+                        pos.do_move(m, states[ply++]);
+
+                    if (pos.checkers())
+                        continue;
+
+                    const double target =  lambda * Math::sigmoid(ps.score * score_k)
+                                         + (1.0 - lambda) * (ps.game_result + 1) / 2.0;
+
+                    pos.sfen_pack(entries[i].sfen);
+                    entries[i].target = float(ply % 2 ? 1.0 - target : target);
+                    valid[i] = true;
+                }
+            });
+            Threads.wait_for_workers_finished();
+
+            size_t n = 0;
+            for (size_t i = 0; i < entries.size(); ++i)
+                if (valid[i])
+                    entries[n++] = entries[i];
+
+            entries.resize(n);
+            return entries;
+        }
+    }
+
+    // Tune the TUNE() parameters of the classical evaluation.
+    // Example: tune epochs 10 iterations 200 lr 2 data.binpack
+    // The parameters to tune are registered as usual, e.g. with
+    // TUNE(SetRange(0, 400), KingProximity) in evaluate.cpp.
+    void tune(Position& pos, istringstream& is)
+    {
+        vector<string> filenames;
+        uint64_t max_positions = UINT64_MAX;
+        int eval_limit = 3000;
+        bool use_draw_games = true;
+
+        // Weight of the teacher score in the target, the rest is the game result
+        double lambda = 0.0;
+
+        int epochs = 10;
+        int iterations = 200;
+        double learning_rate = 2.0;
+
+        // Step of the central differences
+        int step = 4;
+
+        // Scale of the sigmoid, fitted to the data when 0
+        double k = 0.0;
+
+        // Only tune parameters whose name matches this
+        string params_regex = ".*";
+
+        string option;
+        while (is >> option)
+        {
+            if (option == "max_positions") is >> max_positions;
+            else if (option == "eval_limit") is >> eval_limit;
+            else if (option == "use_draw_games") is >> use_draw_games;
+            else if (option == "lambda") is >> lambda;
+            else if (option == "epochs") is >> epochs;
+            else if (option == "iterations") is >> iterations;
+            else if (option == "lr") is >> learning_rate;
+            else if (option == "step") is >> step;
+            else if (option == "k") is >> k;
+            else if (option == "params") is >> params_regex;
+            else
+                filenames.push_back(option);
+        }
+
+        vector<Param> params;
+        const std::regex params_filter(params_regex);
+        for (const auto& [name, range] : Tune::options)
+            if (std::regex_match(name, params_filter))
+            {
+                const int value = int(Options[name]);
+                params.push_back({ name, range.first, range.second, value, double(value) });
+            }
+
+        if (params.empty() || filenames.empty())
+        {
+            cout << "Error! : tune needs training data and parameters registered with TUNE()." << endl;
+            return;
+        }
+
+        cout << "tune" << endl
+             << "parameters        : " << params.size() << endl
+             << "epochs            : " << epochs << endl
+             << "iterations        : " << iterations << endl
+             << "learning rate     : " << learning_rate << endl
+             << "step              : " << step << endl
+             << "lambda            : " << lambda << endl
+             << "eval_limit        : " << eval_limit << endl
+             << "use_draw_games    : " << use_draw_games << endl;
+
+        // The tuned evaluation is the classical one
+        const string use_nnue = Options["Use NNUE"];
+        UCI::setoption("Use NNUE", "false");
+
+        vector<Entry> entries = quiet_entries(read_positions(pos, filenames, max_positions),
+                                              lambda, eval_limit, use_draw_games);
+
+        cout << "quiet positions   : " << entries.size() << endl;
+
+        const size_t thread_num = Threads.size();
+        vector<double> evals(entries.size());
+
+        evaluate_all(entries, [&](size_t, size_t i, Value v) { evals[i] = v; });
+
+        if (k == 0.0)
+            k = fit_k(entries, evals);
+
+        double loss = mean_squared_error(entries, evals, k);
+
+        cout << "K                 : " << k << endl
+             << "initial loss      : " << loss << endl;
+
+        // Per thread derivatives of each parameter and the residuals of the
+        // linear model, see the comment at the top of the file.
+        vector<vector<vector<Coefficient>>> coefficients(thread_num, vector<vector<Coefficient>>(params.size()));
+        vector<vector<double>> residuals(thread_num);
+        vector<double> plus(entries.size());
+
+        for (int epoch = 1; epoch <= epochs; ++epoch)
+        {
+            const TimePoint start = now();
+            uint64_t nonzero = 0;
+
+            for (size_t j = 0; j < params.size(); ++j)
+            {
+                Param& p = params[j];
+                const int lo = std::max(p.min, p.value - step);
+                const int hi = std::min(p.max, p.value + step);
+
+                for (auto& c : coefficients)
+                    c[j].clear();
+
+                if (lo == hi)
+                    continue;
+
+                set_param(p, hi);
+                evaluate_all(entries, [&](size_t, size_t i, Value v) { plus[i] = v; });
+
+                set_param(p, lo);
+                evaluate_all(entries, [&](size_t t, size_t i, Value v) {
+                    if (plus[i] != v)
+                        coefficients[t][j].push_back({ uint32_t(i - thread_range(entries.size(), t).first),
+                                                       float(plus[i] - v) / (hi - lo) });
+                });
+
+                set_param(p, p.value);
+
+                for (auto& c : coefficients)
+                    nonzero += c[j].size();
+            }
+
+            double linear_loss = 0.0;
+
+            for (int it = 0; it < iterations; ++it)
+            {
+                vector<vector<double>> gradients(thread_num, vector<double>(params.size()));
+                vector<double> losses(thread_num);
+
+                Threads.execute_with_workers([&](Thread& th) {
+                    const size_t t = th.thread_idx();
+                    const auto [begin, end] = thread_range(entries.size(), t);
+                    auto& e = residuals[t];
+
+                    e.assign(evals.begin() + begin, evals.begin() + end);
+
+                    for (size_t j = 0; j < params.size(); ++j)
+                        if (const double d = params[j].x - params[j].value)
+                            for (const auto& c : coefficients[t][j])
+                                e[c.index] += c.value * d;
+
+                    // Derivative of the loss with respect to the eval
+                    for (size_t i = 0; i < e.size(); ++i)
+                    {
+                        const double s = Math::sigmoid(k * e[i]);
+                        const double r = s - entries[begin + i].target;
+                        losses[t] += r * r;
+                        e[i] = 2.0 * r * s * (1.0 - s) * k;
+                    }
+
+                    for (size_t j = 0; j < params.size(); ++j)
+                    {
+                        double g = 0.0;
+                        for (const auto& c : coefficients[t][j])
+                            g += c.value * e[c.index];
+                        gradients[t][j] = g;
+                    }
+                });
+                Threads.wait_for_workers_finished();
+
+                linear_loss = 0.0;
+                for (double l : losses)
+                    linear_loss += l;
+                linear_loss /= std::max<size_t>(entries.size(), 1);
+
+                // Adam
+                constexpr double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+
+                for (size_t j = 0; j < params.size(); ++j)
+                {
+                    Param& p = params[j];
+
+                    double g = 0.0;
+                    for (const auto& grad : gradients)
+                        g += grad[j];
+                    g /= std::max<size_t>(entries.size(), 1);
+
+                    p.m = beta1 * p.m + (1.0 - beta1) * g;
+                    p.v = beta2 * p.v + (1.0 - beta2) * g * g;
+                    p.x -= learning_rate * p.m / (std::sqrt(p.v) + epsilon);
+                    p.x = std::clamp(p.x, double(p.min), double(p.max));
+                }
+            }
+
+            // Apply the rounded values and measure the true loss
+            vector<int> old_values;
+            for (auto& p : params)
+            {
+                old_values.push_back(p.value);
+                p.value = int(std::lround(p.x));
+                set_param(p, p.value);
+            }
+
+            vector<double> new_evals(entries.size());
+            evaluate_all(entries, [&](size_t, size_t i, Value v) { new_evals[i] = v; });
+            const double new_loss = mean_squared_error(entries, new_evals, k);
+
+            cout << "epoch " << epoch
+                 << " : loss = " << new_loss
+                 << " , linear loss = " << linear_loss
+                 << " , nonzero coefficients = " << nonzero
+                 << " , time = " << (now() - start) / 1000.0 << "s" << endl;
+
+            if (new_loss < loss)
+            {
+                loss = new_loss;
+                evals.swap(new_evals);
+            }
+            else
+            {
+                // The linear model was too far off, go back and take smaller steps
+                for (size_t j = 0; j < params.size(); ++j)
+                {
+                    params[j].value = old_values[j];
+                    params[j].x = params[j].value;
+                    params[j].m = params[j].v = 0.0;
+                    set_param(params[j], params[j].value);
+                }
+
+                learning_rate /= 2;
+                cout << "loss did not improve, learning rate = " << learning_rate << endl;
+            }
+        }
+
+        // Ready to be pasted into Tune::read_results()
+        cout << "final loss        : " << loss << endl;
+        for (const auto& p : params)
+            cout << "  TuneResults[\"" << p.name << "\"] = " << p.value << ";" << endl;
+
+        // The tuned values stay set, so they can be tested right away
+        UCI::setoption("Use NNUE", use_nnue);
+    }
+
+} // namespace Learner
@@ -0,0 +1,14 @@
+#ifndef _TUNER_H_
+#define _TUNER_H_
+
+#include "position.h"
+
+#include <sstream>
+
+namespace Learner {
+
+    // Texel-style tuning of the TUNE() parameters of the classical evaluation
+    void tune(Position& pos, std::istringstream& is);
+}
+
+#endif
@@ -23,8 +23,8 @@
 #include "bitboard.h"
 #include "endgame.h"
 #include "position.h"
-#include "psqt.h"
 #include "search.h"
+#include "server.h"
 #include "syzygy/tbprobe.h"
 #include "thread.h"
 #include "tt.h"
@@ -42,7 +42,6 @@ int main(int argc, char* argv[]) {
   CommandLine::init(argc, argv);
   UCI::init(Options);
   Tune::init();
-  PSQT::init(variants.find(Options["UCI_Variant"])->second);
   Bitboards::init();
   Position::init();
   Bitbases::init();
@@ -51,8 +50,12 @@ int main(int argc, char* argv[]) {
   Search::clear(); // After threads are up
   Eval::NNUE::init();
 
-  UCI::loop(argc, argv);
+  if (argc > 1 && std::string(argv[1]) == "server")
+      Server::run(argc, argv);
+  else
+      UCI::loop(argc, argv);
 
+  Eval::NNUE::wait_for_net_swap();
   Threads.set(0);
   variants.clear_all();
   pieceMap.clear_all();
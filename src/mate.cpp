@@ -0,0 +1,373 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <deque>
+
+#include "mate.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+#include "timeman.h"
+
+namespace Mate {
+
+namespace {
+
+  constexpr uint32_t Infinite = 100000000;
+
+  /// Proof and disproof numbers of a node. A node is proven (a forced win of
+  /// the attacker) if pn == 0 and disproven if dn == 0. For proven nodes len
+  /// is the number of plies to the end of the game.
+  struct Node {
+    uint32_t pn, dn;
+    int len;
+  };
+
+  constexpr Node Proven    = { 0, Infinite, 0 };
+  constexpr Node Disproven = { Infinite, 0, 0 };
+  constexpr Node Unknown   = { 1, 1, 0 };
+
+  /// ProofTable stores the proof and disproof numbers of searched nodes in
+  /// buckets of four entries. Within a bucket the entry with the smallest
+  /// searched subtree is replaced.
+  class ProofTable {
+
+    struct Entry {
+      Key key;
+      uint32_t pn, dn;
+      uint32_t work; // Nodes searched below the entry, 0 for empty entries
+      int32_t len;
+    };
+
+    static constexpr size_t BucketSize = 4;
+    static constexpr size_t BucketCount = size_t(1) << 18;
+
+  public:
+    void clear() { table.assign(BucketCount * BucketSize, Entry()); }
+    size_t bytes() const { return table.capacity() * sizeof(Entry); }
+
+    bool probe(Key key, Node& node) const {
+      const Entry* e = &table[mul_hi64(key, BucketCount) * BucketSize];
+      for (size_t i = 0; i < BucketSize; ++i)
+          if (e[i].key == key && e[i].work)
+          {
+              node = { e[i].pn, e[i].dn, e[i].len };
+              return true;
+          }
+      return false;
+    }
+
+    void store(Key key, const Node& node, uint64_t work) {
+      Entry* e = &table[mul_hi64(key, BucketCount) * BucketSize];
+      Entry* replace = e;
+      for (size_t i = 0; i < BucketSize; ++i)
+      {
+          if (e[i].key == key || !e[i].work)
+          {
+              replace = &e[i];
+              break;
+          }
+          if (e[i].work < replace->work)
+              replace = &e[i];
+      }
+      *replace = { key, node.pn, node.dn, uint32_t(std::clamp<uint64_t>(work, 1, UINT32_MAX)), node.len };
+    }
+
+  private:
+    std::vector<Entry> table;
+  };
+
+  ProofTable Table;
+
+  /// Solver implements the df-pn algorithm. Every node is searched until its
+  /// proof or disproof number reaches the threshold given by its parent, so
+  /// that the search stays in the most promising subtree without the memory
+  /// of a best-first proof-number search.
+  class Solver {
+  public:
+    Solver(Position& p, const Limits& l) : pos(p), limits(l), attacker(p.side_to_move()) {}
+
+    void mid(int r, int ply, uint32_t thPn, uint32_t thDn, Node& node);
+    bool extract_pv(int r, std::vector<Move>& pv);
+
+    uint64_t nodes = 0;
+    bool stopped = false;
+
+  private:
+    // Positions are stored with the number of remaining plies, since whether
+    // a mate can be forced depends on it.
+    Key key(int r) const { return pos.key() ^ (Key(r + 1) * 0x9E3779B97F4A7C15ULL); }
+
+    bool expand(int r, int ply, std::vector<Move>& moves, Node& node);
+    void check_limits();
+
+    Position& pos;
+    const Limits& limits;
+    const Color attacker;
+  };
+
+  // Generates the moves of the node. Returns true if the node is decided
+  // without searching its children, e.g., by the end of the game, or if the
+  // attacker has no plies left.
+  bool Solver::expand(int r, int ply, std::vector<Move>& moves, Node& node) {
+
+    const bool orNode = pos.side_to_move() == attacker;
+
+    // Game ends may depend on the moves before, e.g., repetitions, so they
+    // are not stored in the table
+    Value result;
+    if (ply > 0 && pos.is_game_end(result, ply))
+    {
+        node = (orNode ? result > VALUE_DRAW : result < VALUE_DRAW) ? Proven : Disproven;
+        return true;
+    }
+
+    if (orNode && r == 0)
+    {
+        node = Disproven;
+        return true;
+    }
+
+    bool anyLegal = false;
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        anyLegal = true;
+        if (!orNode || !limits.checksOnly || pos.gives_check(m))
+            moves.push_back(m);
+    }
+
+    if (!anyLegal)
+    {
+        result = pos.checkers() ? pos.checkmate_value(ply) : pos.stalemate_value(ply);
+        node = (orNode ? result > VALUE_DRAW : result < VALUE_DRAW) ? Proven : Disproven;
+    }
+    else if (moves.empty() || r == 0)
+        node = Disproven;
+    else
+        return false;
+
+    Table.store(key(r), node, 1);
+    return true;
+  }
+
+  void Solver::check_limits() {
+
+    stopped =  Threads.stop
+            || (limits.nodes && nodes >= limits.nodes)
+            || (limits.time && !(nodes & 1023) && Time.elapsed() >= limits.time);
+  }
+
+  // mid() searches a node until its proof number reaches thPn or its
+  // disproof number reaches thDn, and returns its proof and disproof numbers.
+  void Solver::mid(int r, int ply, uint32_t thPn, uint32_t thDn, Node& node) {
+
+    ++nodes;
+    check_limits();
+
+    std::vector<Move> moves;
+    if (expand(r, ply, moves, node))
+        return;
+
+    struct Child {
+      Move move;
+      Node node;
+    };
+
+    const bool orNode = pos.side_to_move() == attacker;
+    const uint64_t nodesBefore = nodes;
+    std::vector<Child> children;
+    children.reserve(moves.size());
+    StateInfo st;
+
+    for (Move m : moves)
+    {
+        Child c = { m, Unknown };
+        pos.do_move(m, st);
+        Table.probe(key(r - 1), c.node);
+        pos.undo_move(m);
+        children.push_back(c);
+    }
+
+    while (true)
+    {
+        // The attacker needs one proven move, the defender has to disprove
+        // one move. Sums saturate below Infinite unless a term is Infinite.
+        uint64_t sum = 0;
+        uint32_t best = Infinite;
+        int len = orNode ? MAX_PLY : 0;
+        for (const Child& c : children)
+        {
+            const uint32_t sumTerm = orNode ? c.node.dn : c.node.pn;
+            const uint32_t minTerm = orNode ? c.node.pn : c.node.dn;
+            sum = sumTerm == Infinite || sum == Infinite ? Infinite : std::min<uint64_t>(sum + sumTerm, Infinite - 1);
+            best = std::min(best, minTerm);
+            if (c.node.pn == 0)
+                len = orNode ? std::min(len, c.node.len) : std::max(len, c.node.len);
+        }
+        node.pn = orNode ? best : uint32_t(sum);
+        node.dn = orNode ? uint32_t(sum) : best;
+        node.len = len + 1;
+
+        if (node.pn == 0 || node.dn == 0 || node.pn >= thPn || node.dn >= thDn || stopped)
+            break;
+
+        // Search the most proving child, until it gets worse than the second
+        // best one or its parent reaches its thresholds
+        size_t idx = 0;
+        uint32_t second = Infinite;
+        for (size_t i = 1; i < children.size(); ++i)
+        {
+            const uint32_t v = orNode ? children[i].node.pn : children[i].node.dn;
+            const uint32_t bestV = orNode ? children[idx].node.pn : children[idx].node.dn;
+            if (v < bestV)
+                second = bestV, idx = i;
+            else
+                second = std::min(second, v);
+        }
+
+        Child& c = children[idx];
+        uint32_t childPn, childDn;
+        if (orNode)
+        {
+            childPn = uint32_t(std::min<uint64_t>(thPn, uint64_t(second) + 1));
+            childDn = uint32_t(std::min<uint64_t>(uint64_t(thDn) - node.dn + c.node.dn, Infinite));
+        }
+        else
+        {
+            childDn = uint32_t(std::min<uint64_t>(thDn, uint64_t(second) + 1));
+            childPn = uint32_t(std::min<uint64_t>(uint64_t(thPn) - node.pn + c.node.pn, Infinite));
+        }
+
+        pos.do_move(c.move, st);
+        mid(r - 1, ply + 1, childPn, childDn, c.node);
+        pos.undo_move(c.move);
+    }
+
+    Table.store(key(r), node, nodes - nodesBefore + 1);
+  }
+
+  // extract_pv() follows the proof from the root, choosing the shortest mate
+  // for the attacker and the longest defence. Nodes that are no longer in the
+  // table are proven again. Returns whether the line has been replayed up to
+  // a won game end for the attacker.
+  bool Solver::extract_pv(int r, std::vector<Move>& pv) {
+
+    std::deque<StateInfo> states;
+    bool mate = false;
+
+    for (int ply = 0; !stopped; ++ply, --r)
+    {
+        std::vector<Move> moves;
+        Node node;
+        if (expand(r, ply, moves, node))
+        {
+            mate = node.pn == 0;
+            break;
+        }
+
+        const bool orNode = pos.side_to_move() == attacker;
+        Move best = MOVE_NONE;
+
+        for (int attempt = 0; attempt < 2 && !best; ++attempt)
+        {
+            if (attempt)
+            {
+                mid(r, ply, Infinite, Infinite, node);
+                if (node.pn != 0)
+                    break;
+            }
+
+            bool complete = true;
+            int bestLen = 0;
+            for (Move m : moves)
+            {
+                Node child;
+                states.emplace_back();
+                pos.do_move(m, states.back());
+                bool found = Table.probe(key(r - 1), child);
+                pos.undo_move(m);
+                states.pop_back();
+
+                if (found && child.pn == 0)
+                {
+                    if (!best || (orNode ? child.len < bestLen : child.len > bestLen))
+                        best = m, bestLen = child.len;
+                }
+                else
+                    complete = false;
+            }
+
+            // All defences have to be refuted
+            if (!orNode && !complete)
+                best = MOVE_NONE;
+        }
+
+        if (!best)
+            break;
+
+        pv.push_back(best);
+        states.emplace_back();
+        pos.do_move(best, states.back());
+    }
+
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it)
+        pos.undo_move(*it);
+
+    return mate && !stopped;
+  }
+
+} // namespace
+
+
+/// Mate::solve() clears the proof table and searches the root position with
+/// an increasing number of plies, since df-pn returns the first proof it finds
+/// rather than the shortest one.
+
+Result solve(Position& pos, const Limits& limits, std::vector<Move>& pv, uint64_t& nodes) {
+
+  Table.clear();
+  pv.clear();
+
+  Solver solver(pos, limits);
+  Result result = NO_MATE;
+
+  for (int plies = 1; plies <= limits.plies && result == NO_MATE; plies += 2)
+  {
+      Node root;
+      solver.mid(plies, 0, Infinite, Infinite, root);
+
+      result =  root.pn == 0 ? (solver.extract_pv(plies, pv) ? MATE : UNKNOWN)
+              : root.dn == 0 ? NO_MATE
+                             : UNKNOWN;
+  }
+
+  nodes = solver.nodes;
+  return result;
+}
+
+
+/// Mate::memory_usage() adds the proof table to the memory report
+
+void memory_usage(std::vector<MemoryUsage>& usage) {
+
+  if (Table.bytes())
+      usage.push_back({ "Mate solver proof table", Table.bytes() });
+}
+
+} // namespace Mate
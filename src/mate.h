@@ -0,0 +1,53 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATE_H_INCLUDED
+#define MATE_H_INCLUDED
+
+#include <vector>
+
+#include "misc.h"
+#include "types.h"
+
+class Position;
+
+namespace Mate {
+
+enum Result { MATE, NO_MATE, UNKNOWN };
+
+/// Limits of a mate search. The search is also stopped by Threads.stop.
+struct Limits {
+  int plies;          // Maximum number of plies of the mate
+  bool checksOnly;    // The attacker may only play checks, as in tsume problems
+  uint64_t nodes = 0; // Node limit, 0 if none
+  TimePoint time = 0; // Time limit measured with Time.elapsed(), 0 if none
+};
+
+/// solve() runs a depth-first proof-number search (df-pn) for a forced win of
+/// the side to move. On MATE, pv holds the shortest mating line against the
+/// longest defence, which has been replayed up to the final position. NO_MATE
+/// is a disproof within the limits, and UNKNOWN means that the search was
+/// stopped.
+
+Result solve(Position& pos, const Limits& limits, std::vector<Move>& pv, uint64_t& nodes);
+
+void memory_usage(std::vector<MemoryUsage>& usage);
+
+} // namespace Mate
+
+#endif // #ifndef MATE_H_INCLUDED
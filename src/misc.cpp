@@ -445,6 +445,78 @@ void* aligned_large_pages_alloc(size_t allocSize) {
 #endif
 
 
+/// huge_page_bytes() returns how many bytes of the given block are backed by
+/// transparent huge pages, according to /proc/self/smaps.
+
+size_t huge_page_bytes(const void* mem, size_t size) {
+
+#if defined(__linux__)
+  if (!mem || !size)
+      return 0;
+
+  const uintptr_t begin = uintptr_t(mem), end = begin + size;
+  uintptr_t vmaBegin = 0, vmaEnd = 0;
+  size_t bytes = 0;
+
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  while (std::getline(smaps, line))
+  {
+      // Each mapping starts with a line like "7f1c00000000-7f1c00400000 rw-p ..."
+      std::istringstream ss(line);
+      unsigned long long first, last;
+      char dash;
+      if (ss >> std::hex >> first >> dash >> last && dash == '-')
+          vmaBegin = uintptr_t(first), vmaEnd = uintptr_t(last);
+
+      else if (   line.compare(0, 14, "AnonHugePages:") == 0
+               && vmaBegin < end && begin < vmaEnd)
+      {
+          size_t overlap = std::min(end, vmaEnd) - std::max(begin, vmaBegin);
+          bytes += std::min(size_t(std::stoull(line.substr(14))) * 1024, overlap);
+      }
+  }
+
+  return bytes;
+#else
+  (void)mem;
+  (void)size;
+  return 0;
+#endif
+}
+
+
+/// print_memory_usage() prints the memory report, one line per subsystem
+
+void print_memory_usage(std::ostream& os, const std::vector<MemoryUsage>& usage) {
+
+  size_t total = 0, totalHuge = 0;
+
+  os << std::left  << std::setw(40) << "Subsystem"
+     << std::right << std::setw(10) << "Instances"
+                   << std::setw(16) << "Per instance"
+                   << std::setw(16) << "Bytes"
+                   << std::setw(16) << "Huge pages" << "\n";
+
+  for (const MemoryUsage& u : usage)
+  {
+      os << std::left  << std::setw(40) << u.name
+         << std::right << std::setw(10) << u.instances
+                       << std::setw(16) << u.bytes / std::max(u.instances, size_t(1))
+                       << std::setw(16) << u.bytes
+                       << std::setw(16) << u.hugePageBytes << "\n";
+
+      total += u.bytes;
+      totalHuge += u.hugePageBytes;
+  }
+
+  os << std::left  << std::setw(66) << "Total"
+     << std::right << std::setw(16) << total
+                   << std::setw(16) << totalHuge
+     << "\nTotal MB: " << (total + (1 << 19)) / (1 << 20);
+}
+
+
 /// aligned_large_pages_free() will free the previously allocated ttmem
 
 #if defined(_WIN32)
@@ -32,6 +32,7 @@
 #include <cctype>
 #include <sstream>
 #include <cstdint>
+#include <type_traits>
 
 #include "types.h"
 
@@ -43,6 +44,19 @@ void* std_aligned_alloc(size_t alignment, size_t size);
 void std_aligned_free(void* ptr);
 void* aligned_large_pages_alloc(size_t size); // memory aligned by page size, min alignment: 4096 bytes
 void aligned_large_pages_free(void* mem); // nop if mem == nullptr
+size_t huge_page_bytes(const void* mem, size_t size); // only measured on Linux, 0 elsewhere
+
+/// MemoryUsage is one line of the memory report: the memory used by a
+/// subsystem, summed over all its instances (e.g. one per thread).
+
+struct MemoryUsage {
+  std::string name;
+  size_t bytes;
+  size_t hugePageBytes = 0;
+  size_t instances = 1;
+};
+
+void print_memory_usage(std::ostream& os, const std::vector<MemoryUsage>& usage);
 
 void dbg_hit_on(bool b);
 void dbg_hit_on(bool c, bool b);
@@ -56,12 +70,25 @@ inline TimePoint now() {
         (std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+/// HashTable is a table of Size entries indexed by the lower bits of the key.
+/// It does not own its memory: the owner provides a zero-initialized block of
+/// Bytes bytes via attach(), which allows to keep several tables in one block
+/// of large pages (see Thread::allocate_tables()).
+
 template<class Entry, int Size>
 struct HashTable {
+
+  static_assert((Size & (Size - 1)) == 0, "Size must be a power of 2");
+  static_assert(std::is_trivially_copyable<Entry>::value, "Entries are zero-initialized");
+
+  // Size of the table in bytes, rounded up to whole cache lines
+  static constexpr size_t Bytes = (Size * sizeof(Entry) + 63) / 64 * 64;
+
   Entry* operator[](Key key) { return &table[(uint32_t)key & (Size - 1)]; }
+  void attach(void* mem) { table = static_cast<Entry*>(mem); }
 
 private:
-  std::vector<Entry> table = std::vector<Entry>(Size); // Allocate on the heap
+  Entry* table = nullptr;
 };
 
 
@@ -22,6 +22,8 @@
 
 #include "position.h"
 #include "misc.h"
+#include "search.h"
+#include "thread.h"
 #include "uci.h"
 #include "types.h"
 
@@ -29,6 +31,19 @@
 #include <string>
 #include <fstream>
 #include <set>
+#include <map>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+// Nets can be embedded with "make build nnue=yes [nets=...]", which generates
+// embedded_nets.h with one EMBEDDED_NET(id, variant, file) entry per net.
+#if !defined(NNUE_EMBEDDING_OFF) && !defined(_MSC_VER)
+#include "../incbin/incbin.h"
+#define EMBEDDED_NET(id, variant, file) INCBIN(EmbeddedNNUE##id, file);
+#include "../embedded_nets.h"
+#undef EMBEDDED_NET
+#endif
 
 namespace Eval::NNUE {
 
@@ -278,8 +293,8 @@ namespace Eval::NNUE {
         return !stream.fail();
     }
 
-    // Read network parameters
-    bool read_parameters(std::istream& stream) {
+    // Read network parameters into the given transformer and network
+    static bool read_parameters(std::istream& stream, FeatureTransformer& transformer, Network& net) {
 
         std::uint32_t hash_value;
         std::string architecture;
@@ -289,14 +304,20 @@ namespace Eval::NNUE {
         if (hash_value != kHashValue)
             return false;
 
-        if (!Detail::read_parameters(stream, *feature_transformer))
+        if (!Detail::read_parameters(stream, transformer))
             return false;
 
-        if (!Detail::read_parameters(stream, *network))
+        if (!Detail::read_parameters(stream, net))
             return false;
 
         return stream && stream.peek() == std::ios::traits_type::eof();
     }
+
+    // Read network parameters
+    bool read_parameters(std::istream& stream) {
+
+        return read_parameters(stream, *feature_transformer, *network);
+    }
     // write evaluation function parameters
     bool write_parameters(std::ostream& stream) {
 
@@ -311,21 +332,47 @@ namespace Eval::NNUE {
 
         return !stream.fail();
     }
-    // Evaluation function. Perform differential calculation.
-    Value evaluate(const Position& pos) {
+    static Value evaluate(const Position& pos, const FeatureTransformer& transformer, const Network& net) {
 
         alignas(kCacheLineSize) TransformedFeatureType
             transformed_features[FeatureTransformer::kBufferSize];
 
-        feature_transformer->transform(pos, transformed_features);
+        transformer.transform(pos, transformed_features);
 
         alignas(kCacheLineSize) char buffer[Network::kBufferSize];
 
-        const auto output = network->propagate(transformed_features, buffer);
+        const auto output = net.propagate(transformed_features, buffer);
 
         return static_cast<Value>(output[0] / FV_SCALE);
     }
 
+    // Evaluation function. Perform differential calculation. Searches use
+    // the net published by swap_net() at their start, if any.
+    Value evaluate(const Position& pos) {
+
+        const Thread* th = pos.this_thread();
+        if (th && th->nnueNet)
+            return evaluate(pos, *th->nnueNet->feature_transformer, *th->nnueNet->network);
+
+        return evaluate(pos, *feature_transformer, *network);
+    }
+
+    // Evaluation with a separately loaded net. Accumulators computed by another
+    // net are not reused, since they store the id of their net.
+    Value evaluate(const Position& pos, const Net& net) {
+
+        return evaluate(pos, *net.feature_transformer, *net.network);
+    }
+
+    // Load a net into its own instance, independent of the global one
+    bool load_net(Net& net, std::istream& stream) {
+
+        Detail::initialize(net.feature_transformer);
+        Detail::initialize(net.network);
+
+        return read_parameters(stream, *net.feature_transformer, *net.network);
+    }
+
     // Load eval, from a file stream or a memory stream
     bool load_eval(std::string name, std::istream& stream) {
 
@@ -335,6 +382,143 @@ namespace Eval::NNUE {
         return read_parameters(stream);
     }
 
+    namespace {
+
+        // Net published by swap_net(). Each search takes a reference at its
+        // start, so the previous net is freed once the last search using it
+        // has finished.
+        std::shared_ptr<const Net> published_net;
+        std::string published_net_name;
+        std::mutex published_net_mutex;
+        std::thread net_loader;
+
+        void publish_net(std::shared_ptr<const Net> net, const std::string& name) {
+
+            std::lock_guard<std::mutex> lk(published_net_mutex);
+            published_net = std::move(net);
+            published_net_name = name;
+        }
+
+        struct EmbeddedNet {
+            const char* variant;
+            const char* name;
+            const unsigned char* data;
+            unsigned int size;
+        };
+
+        const EmbeddedNet EmbeddedNets[] = {
+#if !defined(NNUE_EMBEDDING_OFF) && !defined(_MSC_VER)
+#define EMBEDDED_NET(id, variant, file) { variant, file, gEmbeddedNNUE##id##Data, gEmbeddedNNUE##id##Size },
+#include "../embedded_nets.h"
+#undef EMBEDDED_NET
+#endif
+            { nullptr, nullptr, nullptr, 0 }
+        };
+
+        // Embedded nets that were read before but are not in use, by name
+        std::map<std::string, Net> parsed_embedded_nets;
+
+        // Name of the embedded net in use, empty if the net was read from a file
+        std::string embedded_net_loaded;
+
+        class MemoryBuffer : public std::basic_streambuf<char> {
+        public:
+            MemoryBuffer(char* p, size_t n) { setg(p, p, p + n); setp(p, p + n); }
+        };
+
+        // With the default EvalFile the net embedded for the variant is used,
+        // otherwise an embedded net can be selected by its file name.
+        const EmbeddedNet* find_embedded_net(const std::string& eval_file, const std::string& variant) {
+
+            if (eval_file == EvalFileDefaultName)
+                for (const EmbeddedNet* e = EmbeddedNets; e->name; ++e)
+                    if (variant == e->variant)
+                        return e;
+
+            for (const EmbeddedNet* e = EmbeddedNets; e->name; ++e)
+                if (eval_file == e->name)
+                    return e;
+
+            return nullptr;
+        }
+
+        // Keep the embedded net in use, so that switching back to it is cheap
+        void stash_embedded_net() {
+
+            if (embedded_net_loaded.empty())
+                return;
+
+            Net& net = parsed_embedded_nets[embedded_net_loaded];
+            net.feature_transformer = std::move(feature_transformer);
+            net.network = std::move(network);
+            embedded_net_loaded.clear();
+        }
+
+        // Use an embedded net, it is only read on first use
+        bool load_embedded_net(const EmbeddedNet& e) {
+
+            if (embedded_net_loaded == e.name)
+                return true;
+
+            stash_embedded_net();
+
+            auto it = parsed_embedded_nets.find(e.name);
+            if (it != parsed_embedded_nets.end())
+            {
+                feature_transformer = std::move(it->second.feature_transformer);
+                network = std::move(it->second.network);
+                parsed_embedded_nets.erase(it);
+                fileName = e.name;
+            }
+            else
+            {
+                MemoryBuffer buffer(const_cast<char*>(reinterpret_cast<const char*>(e.data)), size_t(e.size));
+                std::istream stream(&buffer);
+                if (!load_eval(e.name, stream))
+                    return false;
+
+                Search::print(std::string("info string Loaded embedded eval file ") + e.name + " for " + e.variant);
+            }
+
+            embedded_net_loaded = e.name;
+            return true;
+        }
+    }
+
+    // Load a net in the background and publish it for the following searches,
+    // while a running search finishes with the net it started with.
+    void swap_net(const std::string& file) {
+
+        wait_for_net_swap();
+
+        net_loader = std::thread([file] {
+            auto net = std::make_shared<Net>();
+            std::ifstream stream(file, std::ios::binary);
+            if (!load_net(*net, stream))
+            {
+                Search::print("info string ERROR: failed to load eval file " + file);
+                return;
+            }
+
+            publish_net(std::move(net), file);
+            Search::print("info string Loaded eval file " + file + " for the next search");
+        });
+    }
+
+    // Wait for a net being loaded by swap_net()
+    void wait_for_net_swap() {
+
+        if (net_loader.joinable())
+            net_loader.join();
+    }
+
+    // The net published by swap_net(), nullptr if the loaded eval file is used
+    std::shared_ptr<const Net> swapped_net() {
+
+        std::lock_guard<std::mutex> lk(published_net_mutex);
+        return published_net;
+    }
+
     static UseNNUEMode nnue_mode_from_option(const UCI::Option& mode)
     {
         if (mode == "false")
@@ -351,6 +535,10 @@ namespace Eval::NNUE {
 
         useNNUE = nnue_mode_from_option(Options["Use NNUE"]);
 
+        // An explicitly selected eval file replaces a swapped in net
+        wait_for_net_swap();
+        publish_net(nullptr, "");
+
         if (Options["SkipLoadingEval"] || useNNUE == UseNNUEMode::False)
         {
             eval_file_loaded.clear();
@@ -359,6 +547,25 @@ namespace Eval::NNUE {
 
         std::string eval_file = std::string(Options["EvalFile"]);
 
+        // Embedded nets need no file system access
+        if (const EmbeddedNet* e = find_embedded_net(eval_file, Options["UCI_Variant"]))
+        {
+            if (load_embedded_net(*e))
+                eval_file_loaded = eval_file;
+            else
+            {
+                Search::print(std::string("info string ERROR: failed to load embedded eval file ") + e->name);
+                eval_file_loaded.clear();
+            }
+            return;
+        }
+
+        if (!embedded_net_loaded.empty())
+        {
+            stash_embedded_net();
+            eval_file_loaded.clear();
+        }
+
 #if defined(DEFAULT_NNUE_DIRECTORY)
 #define stringify2(x) #x
 #define stringify(x) stringify2(x)
@@ -374,12 +581,12 @@ namespace Eval::NNUE {
                 std::ifstream stream(directory + eval_file, std::ios::binary);
                 if (load_eval(eval_file, stream))
                 {
-                    sync_cout << "info string Loaded eval file " << directory + eval_file << sync_endl;
+                    Search::print("info string Loaded eval file " + directory + eval_file);
                     eval_file_loaded = eval_file;
                 }
                 else
                 {
-                    sync_cout << "info string ERROR: failed to load eval file " << directory + eval_file << sync_endl;
+                    Search::print("info string ERROR: failed to load eval file " + directory + eval_file);
                     eval_file_loaded.clear();
                 }
             }
@@ -389,12 +596,44 @@ namespace Eval::NNUE {
 #undef stringify
     }
 
+    // Add the nets in memory to the memory report
+    void memory_usage(std::vector<MemoryUsage>& usage) {
+
+        if (feature_transformer)
+            usage.push_back({ "NNUE feature transformer", sizeof(FeatureTransformer),
+                              huge_page_bytes(feature_transformer.get(), sizeof(FeatureTransformer)) });
+        if (network)
+            usage.push_back({ "NNUE network", sizeof(Network) });
+
+        if (std::shared_ptr<const Net> net = swapped_net())
+            usage.push_back({ "NNUE swapped in net", sizeof(FeatureTransformer) + sizeof(Network),
+                              huge_page_bytes(net->feature_transformer.get(), sizeof(FeatureTransformer)) });
+
+        if (!parsed_embedded_nets.empty())
+        {
+            size_t hugePageBytes = 0;
+            for (const auto& [name, net] : parsed_embedded_nets)
+                hugePageBytes += huge_page_bytes(net.feature_transformer.get(), sizeof(FeatureTransformer));
+
+            usage.push_back({ "NNUE embedded nets not in use",
+                              parsed_embedded_nets.size() * (sizeof(FeatureTransformer) + sizeof(Network)),
+                              hugePageBytes, parsed_embedded_nets.size() });
+        }
+    }
+
+    /// NNUE::is_eval_file_loaded() tests whether the net of EvalFile is loaded,
+    /// if NNUE evaluation is used
+    bool is_eval_file_loaded() {
+
+        return useNNUE == UseNNUEMode::False || eval_file_loaded == std::string(Options["EvalFile"]);
+    }
+
     /// NNUE::verify() verifies that the last net used was loaded successfully
     void verify_eval_file_loaded() {
 
         std::string eval_file = std::string(Options["EvalFile"]);
 
-        if (useNNUE != UseNNUEMode::False && eval_file_loaded != eval_file)
+        if (!is_eval_file_loaded())
         {
             UCI::OptionsMap defaults;
             UCI::init(defaults);
@@ -405,19 +644,25 @@ namespace Eval::NNUE {
             std::string msg4 = "The default net can be downloaded from: https://tests.stockfishchess.org/api/nn/" + std::string(defaults["EvalFile"]);
             std::string msg5 = "The engine will be terminated now.";
 
-            sync_cout << "info string ERROR: " << msg1 << sync_endl;
-            sync_cout << "info string ERROR: " << msg2 << sync_endl;
-            sync_cout << "info string ERROR: " << msg3 << sync_endl;
-            sync_cout << "info string ERROR: " << msg4 << sync_endl;
-            sync_cout << "info string ERROR: " << msg5 << sync_endl;
+            Search::print("info string ERROR: " + msg1);
+            Search::print("info string ERROR: " + msg2);
+            Search::print("info string ERROR: " + msg3);
+            Search::print("info string ERROR: " + msg4);
+            Search::print("info string ERROR: " + msg5);
 
             std::exit(EXIT_FAILURE);
         }
 
+        std::string swapped_name;
+        {
+            std::lock_guard<std::mutex> lk(published_net_mutex);
+            swapped_name = published_net_name;
+        }
+
         if (useNNUE != UseNNUEMode::False)
-            sync_cout << "info string NNUE evaluation using " << eval_file << " enabled" << sync_endl;
+            Search::print("info string NNUE evaluation using " + (swapped_name.empty() ? eval_file : swapped_name) + " enabled");
         else
-            sync_cout << "info string classical evaluation enabled" << sync_endl;
+            Search::print("info string classical evaluation enabled");
     }
 
     /// In training we override eval file so this is useful.
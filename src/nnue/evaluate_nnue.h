@@ -95,10 +95,23 @@ namespace Eval::NNUE {
     // write evaluation function parameters
     bool write_parameters(std::ostream& stream);
 
+    // A net loaded into its own instance, e.g. to compare several nets
+    struct Net {
+        LargePagePtr<FeatureTransformer> feature_transformer;
+        AlignedPtr<Network> network;
+    };
+
     Value evaluate(const Position& pos);
+    Value evaluate(const Position& pos, const Net& net);
+    bool load_net(Net& net, std::istream& stream);
     bool load_eval(std::string name, std::istream& stream);
+    void swap_net(const std::string& file);
+    void wait_for_net_swap();
+    std::shared_ptr<const Net> swapped_net();
     void init();
+    void memory_usage(std::vector<MemoryUsage>& usage);
 
+    bool is_eval_file_loaded();
     void verify_eval_file_loaded();
     void verify_any_net_loaded();
 
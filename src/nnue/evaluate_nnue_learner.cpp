@@ -216,4 +216,19 @@ namespace Eval::NNUE {
 
         std::cout << "save_eval() finished. folder = " << eval_dir << std::endl;
     }
+
+    // Add the trainer and the examples waiting for training to the memory report
+    void learner_memory_usage(std::vector<MemoryUsage>& usage) {
+        if (trainer)
+            usage.push_back({ "NNUE trainer parameters and buffers", trainer->get_memory_usage() });
+
+        std::lock_guard<std::mutex> lock(examples_mutex);
+
+        std::size_t bytes = examples.capacity() * sizeof(Example);
+        for (const auto& example : examples)
+            bytes += (example.training_features[0].capacity() + example.training_features[1].capacity())
+                   * sizeof(TrainingFeature);
+
+        usage.push_back({ "NNUE training examples", bytes });
+    }
 }  // namespace Eval::NNUE
\ No newline at end of file
@@ -34,6 +34,9 @@ namespace Eval::NNUE {
     void finalize_net();
 
     void save_eval(std::string suffix);
+
+    // Add the trainer and the examples waiting for training to the memory report
+    void learner_memory_usage(std::vector<MemoryUsage>& usage);
 }  // namespace Eval::NNUE
 
 #endif
@@ -28,6 +28,7 @@ namespace Eval::NNUE {
     struct alignas(kCacheLineSize) Accumulator {
         std::int16_t accumulation[2][kRefreshTriggers.size()][kTransformedFeatureDimensions];
         bool computed_accumulation;
+        std::uint32_t net_id; // Feature transformer that computed the accumulation
     };
 
 }  // namespace Eval::NNUE
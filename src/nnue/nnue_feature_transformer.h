@@ -26,6 +26,7 @@
 
 #include "features/index_list.h"
 
+#include <atomic>
 #include <cstring>
 #include <string>
 
@@ -123,9 +124,13 @@ namespace Eval::NNUE {
                 std::to_string(kHalfDimensions) + "x2]";
         }
 
-        // Read network parameters
+        // Read network parameters. Every read gets a new id, so that the
+        // accumulations of previously read parameters are not reused.
         bool read_parameters(std::istream& stream) {
 
+            static std::atomic<std::uint32_t> last_id(0);
+            id_ = ++last_id;
+
             for (std::size_t i = 0; i < kHalfDimensions; ++i)
                 biases_[i] = read_little_endian<BiasType>(stream);
 
@@ -150,11 +155,11 @@ namespace Eval::NNUE {
         bool update_accumulator_if_possible(const Position& pos) const {
 
             const auto now = pos.state();
-            if (now->accumulator.computed_accumulation)
+            if (now->accumulator.computed_accumulation && now->accumulator.net_id == id_)
                 return true;
 
             const auto prev = now->previous;
-            if (prev && prev->accumulator.computed_accumulation) {
+            if (prev && prev->accumulator.computed_accumulation && prev->accumulator.net_id == id_) {
                 update_accumulator(pos);
                 return true;
             }
@@ -354,6 +359,7 @@ namespace Eval::NNUE {
 #endif
 
             accumulator.computed_accumulation = true;
+            accumulator.net_id = id_;
         }
 
         // Calculate cumulative value using difference calculation
@@ -454,6 +460,7 @@ namespace Eval::NNUE {
 #endif
             }
             accumulator.computed_accumulation = true;
+            accumulator.net_id = id_;
         }
 
         using BiasType = std::int16_t;
@@ -465,6 +472,7 @@ namespace Eval::NNUE {
         alignas(kCacheLineSize) BiasType biases_[kHalfDimensions];
         alignas(kCacheLineSize)
             WeightType weights_[kHalfDimensions * kInputDimensions];
+        std::uint32_t id_;
     };
 
 }  // namespace Eval::NNUE
@@ -209,6 +209,13 @@ namespace Eval::NNUE {
             previous_layer_trainer_->backpropagate(gradients_.data(), learning_rate);
         }
 
+        // Bytes used by this trainer and the trainers of its inputs
+        std::size_t get_memory_usage() {
+            return sizeof(*this)
+                 + (output_.capacity() + gradients_.capacity()) * sizeof(LearnFloatType)
+                 + previous_layer_trainer_->get_memory_usage();
+        }
+
     private:
         // constructor
         Trainer(LayerType* target_layer, FeatureTransformer* ft) :
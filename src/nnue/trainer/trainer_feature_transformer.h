@@ -250,6 +250,12 @@ namespace Eval::NNUE {
             }
         }
 
+        // Bytes used by this trainer
+        std::size_t get_memory_usage() {
+            return sizeof(*this)
+                 + (output_.capacity() + gradients_.capacity()) * sizeof(LearnFloatType);
+        }
+
     private:
         // constructor
         Trainer(LayerType* target_layer) :
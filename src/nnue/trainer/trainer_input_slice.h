@@ -118,6 +118,27 @@ namespace Eval::NNUE {
             }
         }
 
+        // Bytes used by this trainer and the feature transformer trainer,
+        // counted only once for all layers sharing it
+        std::size_t get_memory_usage() {
+            std::size_t bytes = 0;
+            if (num_calls_ == 0) {
+                current_operation_ = Operation::kGetMemoryUsage;
+                bytes = sizeof(*this)
+                      + gradients_.capacity() * sizeof(LearnFloatType)
+                      + feature_transformer_trainer_->get_memory_usage();
+            }
+
+            assert(current_operation_ == Operation::kGetMemoryUsage);
+
+            if (++num_calls_ == num_referrers_) {
+                num_calls_ = 0;
+                current_operation_ = Operation::kNone;
+            }
+
+            return bytes;
+        }
+
     private:
         // constructor
         SharedInputTrainer(FeatureTransformer* ft) :
@@ -141,6 +162,7 @@ namespace Eval::NNUE {
             kInitialize,
             kPropagate,
             kBackPropagate,
+            kGetMemoryUsage,
         };
 
         // number of samples in mini-batch
@@ -236,6 +258,13 @@ namespace Eval::NNUE {
             shared_input_trainer_->backpropagate(gradients_.data(), learning_rate);
         }
 
+        // Bytes used by this trainer and the shared input trainer
+        std::size_t get_memory_usage() {
+            return sizeof(*this)
+                 + (output_.capacity() + gradients_.capacity()) * sizeof(LearnFloatType)
+                 + shared_input_trainer_->get_memory_usage();
+        }
+
     private:
         // constructor
         Trainer(FeatureTransformer* ft):
@@ -73,6 +73,13 @@ namespace Eval::NNUE {
             previous_layer_trainer_->backpropagate(gradients, learning_rate);
         }
 
+        // Bytes used by this trainer and the trainers of its inputs
+        std::size_t get_memory_usage() {
+            return sizeof(*this) - sizeof(Tail)
+                 + Tail::get_memory_usage()
+                 + previous_layer_trainer_->get_memory_usage();
+        }
+
     private:
         // constructor
         Trainer(LayerType* target_layer, FeatureTransformer* ft):
@@ -158,6 +165,13 @@ namespace Eval::NNUE {
             previous_layer_trainer_->backpropagate(gradients, learning_rate);
         }
 
+        // Bytes used by this trainer and the trainer of its input
+        std::size_t get_memory_usage() {
+            return sizeof(*this)
+                 + output_.capacity() * sizeof(LearnFloatType)
+                 + previous_layer_trainer_->get_memory_usage();
+        }
+
     private:
         // constructor
         Trainer(LayerType* target_layer, FeatureTransformer* ft) :
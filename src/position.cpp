@@ -254,6 +254,7 @@ Position& Position::set(const Variant* v, const string& fenStr, bool isChess960,
   st = si;
 
   var = v;
+  psqt = &v->psqt();
 
   ss >> std::noskipws;
 
@@ -832,6 +833,23 @@ Bitboard Position::attackers_to(Square s, Bitboard occupied, Color c, Bitboard j
             | (LeaperAttacks[~c][SHOGI_PAWN][s]   & pieces(c, SHOGI_PAWN, SILVER));
   }
 
+  // Use the cached attacks of the pieces if the occupancy is unchanged
+  if (var->cachedAttacks && occupied == byTypeBB[ALL_PIECES])
+  {
+      if (attacksDirty)
+          update_attacks();
+
+      Bitboard b = 0;
+      Bitboard candidates = pieces(c);
+      while (candidates)
+      {
+          Square s2 = pop_lsb(&candidates);
+          if (pieceAttacks[s2] & s)
+              b |= s2;
+      }
+      return b;
+  }
+
   Bitboard b = 0;
   for (PieceType pt : piece_types())
       if (board_bb(c, pt) & s)
@@ -889,6 +907,52 @@ Bitboard Position::attackers_to(Square s, Bitboard occupied) const {
 }
 
 
+/// Position::update_attacks() recomputes the cached attacks and quiet moves
+/// of the pieces affected by the board changes since the last update: the
+/// pieces on changed squares and the riders, hoppers and lame leapers whose
+/// lines pass through one of them. The occupancy relevant for a piece is
+/// given by the masks of the magic bitboards of its rider types.
+
+void Position::update_attacks() const {
+
+  assert(var->cachedAttacks);
+
+  Bitboard dirty = attacksDirty;
+  Bitboard b = dirty | riderSquares;
+  attacksDirty = 0;
+
+  while (b)
+  {
+      Square s = pop_lsb(&b);
+      if (!(dirty & s) && !(attackDependencies[s] & dirty))
+          continue;
+
+      if (!(byTypeBB[ALL_PIECES] & s))
+      {
+          riderSquares &= ~square_bb(s);
+          attackDependencies[s] = 0;
+          continue;
+      }
+
+      Color c = color_of(board[s]);
+      PieceType pt = type_of(board[s]);
+      PieceType movePt = pt == KING ? king_type() : pt;
+      pieceAttacks[s] = compute_attacks(c, pt, s);
+      pieceMoves[s] = compute_moves(c, pt, s);
+
+      Bitboard dependencies = 0;
+      RiderType r = AttackRiderTypes[movePt] | MoveRiderTypes[movePt];
+      while (r)
+          dependencies |= magics[lsb(pop_rider(&r))][s].mask;
+      attackDependencies[s] = dependencies;
+      if (dependencies)
+          riderSquares |= s;
+      else
+          riderSquares &= ~square_bb(s);
+  }
+}
+
+
 /// Position::legal() tests whether a pseudo-legal move is legal
 
 bool Position::legal(Move m) const {
@@ -2033,7 +2097,7 @@ Value Position::blast_see(Move m) const {
       {
           Square s = pop_lsb(&attackers);
           if (extinction_piece_types().find(type_of(piece_on(s))) == extinction_piece_types().end())
-              minAttacker = std::min(minAttacker, blast & s ? VALUE_ZERO : CapturePieceValue[MG][piece_on(s)]);
+              minAttacker = std::min(minAttacker, blast & s ? VALUE_ZERO : psqt->capturePieceValue[MG][piece_on(s)]);
       }
 
       if (minAttacker == VALUE_INFINITE)
@@ -2041,7 +2105,7 @@ Value Position::blast_see(Move m) const {
 
       result += minAttacker;
       if (type_of(m) == DROP)
-          result -= CapturePieceValue[MG][dropped_piece_type(m)];
+          result -= psqt->capturePieceValue[MG][dropped_piece_type(m)];
   }
 
   // Sum up blast piece values
@@ -2052,7 +2116,7 @@ Value Position::blast_see(Move m) const {
           return color_of(bpc) == us ?  extinction_value()
                         : capture(m) ? -extinction_value()
                                      : VALUE_ZERO;
-      result += color_of(bpc) == us ? -CapturePieceValue[MG][bpc] : CapturePieceValue[MG][bpc];
+      result += color_of(bpc) == us ? -psqt->capturePieceValue[MG][bpc] : psqt->capturePieceValue[MG][bpc];
   }
 
   return capture(m) || must_capture() ? result - 1 : std::min(result, VALUE_ZERO);
@@ -2206,6 +2270,49 @@ bool Position::see_ge(Move m, Value threshold) const {
   return bool(res);
 }
 
+/// Position::has_insufficient_material() tests whether side c can not win by
+/// checkmate, or by giving checks in check counting variants, any more with its
+/// material. The piece types are classified per
+/// variant in Variant::conclude(), so only the bitboards of the relevant piece
+/// types are looked at.
+
+bool Position::has_insufficient_material(Color c) const {
+
+  // Other win rules
+  if (!var->insufficientMaterialRule || count_in_hand(c, ALL_PIECES))
+      return false;
+
+  // Mating pieces
+  for (PieceType pt : var->matingPieceTypes[c])
+      if (pieces(c, pt))
+          return false;
+
+  // Restricted pieces
+  Bitboard restricted = pieces(~c, KING);
+  for (PieceType pt : var->restrictedPieceTypes[c])
+      restricted |= pieces(c, pt);
+
+  // Checks are counted, so any piece that can reach the enemy king can win
+  if (var->checkCounting)
+      return !(pieces(c) & ~restricted);
+
+  // Color-bound pieces
+  Bitboard colorbound = 0, unbound;
+  for (PieceType pt : var->colorboundPieceTypes)
+      colorbound |= pieces(pt);
+  colorbound &= ~restricted;
+  unbound = pieces() ^ restricted ^ colorbound;
+  if ((colorbound & pieces(c)) && (((DarkSquares & colorbound) && (~DarkSquares & colorbound)) || unbound))
+      return false;
+
+  // Unbound pieces require one helper piece of either color
+  if ((pieces(c) & unbound) && (popcount(pieces() ^ restricted) >= 2 || var->stalemateValue != VALUE_DRAW))
+      return false;
+
+  return true;
+}
+
+
 /// Position::is_optinal_game_end() tests whether the position may end the game by
 /// 50-move rule, by repetition, or a variant rule that allows a player to claim a game result.
 
@@ -287,6 +287,8 @@ public:
   bool is_optional_game_end() const;
   bool is_optional_game_end(Value& result, int ply = 0, int countStarted = 0) const;
   bool is_game_end(Value& result, int ply = 0) const;
+  bool has_insufficient_material(Color c) const;
+  bool is_material_draw() const;
   Value material_counting_result() const;
   bool has_game_cycle(int ply) const;
   bool has_repeated() const;
@@ -338,6 +340,9 @@ private:
   void move_piece(Square from, Square to);
   template<bool Do>
   void do_castling(Color us, Square from, Square& to, Square& rfrom, Square& rto);
+  Bitboard compute_attacks(Color c, PieceType pt, Square s) const;
+  Bitboard compute_moves(Color c, PieceType pt, Square s) const;
+  void update_attacks() const;
 
   // Data members
   Piece board[SQUARE_NB];
@@ -356,10 +361,21 @@ private:
 
   // variant-specific
   const Variant* var;
+  const PSQT::Tables* psqt;
   bool tsumeMode;
   bool chess960;
   int pieceCountInHand[COLOR_NB][PIECE_TYPE_NB];
   Bitboard promotedPieces;
+
+  // Attacks and quiet moves of the piece on each square, only maintained for
+  // variants with cachedAttacks. Changed squares are collected in attacksDirty
+  // and the affected pieces are only recomputed when the attacks are needed.
+  mutable Bitboard attacksDirty;
+  mutable Bitboard riderSquares;
+  mutable Bitboard pieceAttacks[SQUARE_NB];
+  mutable Bitboard pieceMoves[SQUARE_NB];
+  mutable Bitboard attackDependencies[SQUARE_NB];
+
   void add_to_hand(Piece pc);
   void remove_from_hand(Piece pc);
   void drop_piece(Piece pc_hand, Piece pc_drop, Square s);
@@ -906,6 +922,17 @@ inline bool Position::is_game_end(Value& result, int ply) const {
   return is_immediate_game_end(result, ply) || is_optional_game_end(result, ply);
 }
 
+/// Position::is_material_draw() tests whether neither side can win any more.
+/// Mating material is only lost by captures and special moves (promotions,
+/// demotions, ...), so positions reached otherwise are not tested.
+
+inline bool Position::is_material_draw() const {
+  return   var->insufficientMaterialDraw
+        && (st->capturedPiece || type_of(st->move) != NORMAL)
+        && has_insufficient_material(WHITE)
+        && has_insufficient_material(BLACK);
+}
+
 inline Color Position::side_to_move() const {
   return sideToMove;
 }
@@ -1020,10 +1047,7 @@ inline Square Position::castling_rook_square(CastlingRights cr) const {
   return castlingRookSquare[cr];
 }
 
-inline Bitboard Position::attacks_from(Color c, PieceType pt, Square s) const {
-  if (var->fastAttacks || var->fastAttacks2)
-      return attacks_bb(c, pt, s, byTypeBB[ALL_PIECES]) & board_bb();
-
+inline Bitboard Position::compute_attacks(Color c, PieceType pt, Square s) const {
   PieceType movePt = pt == KING ? king_type() : pt;
   Bitboard b = attacks_bb(c, movePt, s, byTypeBB[ALL_PIECES]);
   // Xiangqi soldier
@@ -1051,10 +1075,7 @@ inline Bitboard Position::attacks_from(Color c, PieceType pt, Square s) const {
   return b & board_bb(c, pt);
 }
 
-inline Bitboard Position::moves_from(Color c, PieceType pt, Square s) const {
-  if (var->fastAttacks || var->fastAttacks2)
-      return moves_bb(c, pt, s, byTypeBB[ALL_PIECES]) & board_bb();
-
+inline Bitboard Position::compute_moves(Color c, PieceType pt, Square s) const {
   PieceType movePt = pt == KING ? king_type() : pt;
   Bitboard b = moves_bb(c, movePt, s, byTypeBB[ALL_PIECES]);
   // Xiangqi soldier
@@ -1082,6 +1103,34 @@ inline Bitboard Position::moves_from(Color c, PieceType pt, Square s) const {
   return b & board_bb(c, pt);
 }
 
+inline Bitboard Position::attacks_from(Color c, PieceType pt, Square s) const {
+  if (var->fastAttacks || var->fastAttacks2)
+      return attacks_bb(c, pt, s, byTypeBB[ALL_PIECES]) & board_bb();
+
+  if (var->cachedAttacks && board[s] == make_piece(c, pt) && (byTypeBB[ALL_PIECES] & s))
+  {
+      if (attacksDirty)
+          update_attacks();
+      return pieceAttacks[s];
+  }
+
+  return compute_attacks(c, pt, s);
+}
+
+inline Bitboard Position::moves_from(Color c, PieceType pt, Square s) const {
+  if (var->fastAttacks || var->fastAttacks2)
+      return moves_bb(c, pt, s, byTypeBB[ALL_PIECES]) & board_bb();
+
+  if (var->cachedAttacks && board[s] == make_piece(c, pt) && (byTypeBB[ALL_PIECES] & s))
+  {
+      if (attacksDirty)
+          update_attacks();
+      return pieceMoves[s];
+  }
+
+  return compute_moves(c, pt, s);
+}
+
 inline Bitboard Position::attackers_to(Square s) const {
   return attackers_to(s, pieces());
 }
@@ -1201,11 +1250,12 @@ inline Thread* Position::this_thread() const {
 inline void Position::put_piece(Piece pc, Square s, bool isPromoted, Piece unpromotedPc) {
 
   board[s] = pc;
+  attacksDirty |= s;
   byTypeBB[ALL_PIECES] |= byTypeBB[type_of(pc)] |= s;
   byColorBB[color_of(pc)] |= s;
   pieceCount[pc]++;
   pieceCount[make_piece(color_of(pc), ALL_PIECES)]++;
-  psq += PSQT::psq[pc][s];
+  psq += psqt->psq[pc][s];
   if (isPromoted)
       promotedPieces |= s;
   unpromotedBoard[s] = unpromotedPc;
@@ -1214,13 +1264,14 @@ inline void Position::put_piece(Piece pc, Square s, bool isPromoted, Piece unpro
 inline void Position::remove_piece(Square s) {
 
   Piece pc = board[s];
+  attacksDirty |= s;
   byTypeBB[ALL_PIECES] ^= s;
   byTypeBB[type_of(pc)] ^= s;
   byColorBB[color_of(pc)] ^= s;
   /* board[s] = NO_PIECE;  Not needed, overwritten by the capturing one */
   pieceCount[pc]--;
   pieceCount[make_piece(color_of(pc), ALL_PIECES)]--;
-  psq -= PSQT::psq[pc][s];
+  psq -= psqt->psq[pc][s];
   promotedPieces -= s;
   unpromotedBoard[s] = NO_PIECE;
 }
@@ -1229,12 +1280,13 @@ inline void Position::move_piece(Square from, Square to) {
 
   Piece pc = board[from];
   Bitboard fromTo = square_bb(from) ^ to; // from == to needs to cancel out
+  attacksDirty |= fromTo;
   byTypeBB[ALL_PIECES] ^= fromTo;
   byTypeBB[type_of(pc)] ^= fromTo;
   byColorBB[color_of(pc)] ^= fromTo;
   board[from] = NO_PIECE;
   board[to] = pc;
-  psq += PSQT::psq[pc][to] - PSQT::psq[pc][from];
+  psq += psqt->psq[pc][to] - psqt->psq[pc][from];
   if (is_promoted(from))
       promotedPieces ^= fromTo;
   unpromotedBoard[to] = unpromotedBoard[from];
@@ -1301,13 +1353,13 @@ inline Value Position::material_counting_result() const {
 inline void Position::add_to_hand(Piece pc) {
   pieceCountInHand[color_of(pc)][type_of(pc)]++;
   pieceCountInHand[color_of(pc)][ALL_PIECES]++;
-  psq += PSQT::psq[pc][SQ_NONE];
+  psq += psqt->psq[pc][SQ_NONE];
 }
 
 inline void Position::remove_from_hand(Piece pc) {
   pieceCountInHand[color_of(pc)][type_of(pc)]--;
   pieceCountInHand[color_of(pc)][ALL_PIECES]--;
-  psq -= PSQT::psq[pc][SQ_NONE];
+  psq -= psqt->psq[pc][SQ_NONE];
 }
 
 inline void Position::drop_piece(Piece pc_hand, Piece pc_drop, Square s) {
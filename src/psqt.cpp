@@ -29,10 +29,6 @@
 #include "variant.h"
 #include "misc.h"
 
-Value EvalPieceValue[PHASE_NB][PIECE_NB];
-Value CapturePieceValue[PHASE_NB][PIECE_NB];
-
-
 
 namespace
 {
@@ -114,12 +110,14 @@ constexpr Score PBonus[RANK_NB][FILE_NB] =
 namespace PSQT
 {
 
-Score psq[PIECE_NB][SQUARE_NB + 1];
-
 // PSQT::init() initializes piece-square tables: the white halves of the tables are
 // copied from Bonus[] and PBonus[], adding the piece value, then the black halves of
 // the tables are initialized by flipping and changing the sign of the white scores.
-void init(const Variant* v) {
+void init(const Variant* v, Tables& t) {
+
+  auto& psq = t.psq;
+  auto& EvalPieceValue = t.evalPieceValue;
+  auto& CapturePieceValue = t.capturePieceValue;
 
   PieceType strongestPiece = NO_PIECE_TYPE;
   for (PieceType pt : v->pieceTypes)
@@ -246,4 +244,19 @@ void init(const Variant* v) {
   }
 }
 
+// Cache::compute() is called on the first use of the tables of a variant. If
+// several threads race here, the tables of the first one are kept.
+const Tables& Cache::compute(const Variant* v) const {
+
+  Tables* t = new Tables();
+  init(v, *t);
+
+  const Tables* expected = nullptr;
+  if (tables.compare_exchange_strong(expected, t, std::memory_order_acq_rel))
+      return *t;
+
+  delete t;
+  return *expected;
+}
+
 } // namespace PSQT
@@ -21,17 +21,44 @@
 #define PSQT_H_INCLUDED
 
 
+#include <atomic>
+
 #include "types.h"
 
-#include "variant.h"
+struct Variant;
 
 namespace PSQT
 {
 
-extern Score psq[PIECE_NB][SQUARE_NB + 1];
+/// Tables struct holds the variant-specific piece-square tables and piece values
+struct Tables {
+  Score psq[PIECE_NB][SQUARE_NB + 1];
+  Value evalPieceValue[PHASE_NB][PIECE_NB];    // variant piece values for evaluation
+  Value capturePieceValue[PHASE_NB][PIECE_NB]; // variant piece values for captures/search
+};
+
+// Fill the tables of a variant from a set of internally linked parameters
+extern void init(const Variant* v, Tables& t);
+
+/// Cache owns the tables of a variant, which are computed on first use. Copies
+/// of a variant (e.g. derived from a template) start with an empty cache.
+class Cache {
+public:
+  Cache() = default;
+  Cache(const Cache&) {}
+  Cache& operator=(const Cache&) { return *this; }
+  ~Cache() { delete tables.load(std::memory_order_relaxed); }
+
+  const Tables& get(const Variant* v) const {
+    const Tables* t = tables.load(std::memory_order_acquire);
+    return t ? *t : compute(v);
+  }
+
+private:
+  const Tables& compute(const Variant* v) const;
 
-// Fill psqt array from a set of internally linked parameters
-extern void init(const Variant*);
+  mutable std::atomic<const Tables*> tables{nullptr};
+};
 
 } // namespace PSQT
 
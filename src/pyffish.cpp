@@ -383,7 +383,6 @@ PyMODINIT_FUNC PyInit_pyffish() {
     pieceMap.init();
     variants.init();
     UCI::init(Options);
-    PSQT::init(variants.find(Options["UCI_Variant"])->second);
     Bitboards::init();
     Position::init();
     Bitbases::init();
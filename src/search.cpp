@@ -21,11 +21,14 @@
 #include <cmath>
 #include <cstring>   // For std::memset
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
 
 #include "nnue/evaluate_nnue.h"
 
 #include "evaluate.h"
+#include "mate.h"
 #include "misc.h"
 #include "movegen.h"
 #include "movepick.h"
@@ -42,6 +45,7 @@
 namespace Search {
 
   LimitsType Limits;
+  OutputHooks Hooks;
 }
 
 using std::string;
@@ -50,6 +54,18 @@ using namespace Search;
 
 bool Search::prune_at_shallow_depth = true;
 
+
+/// Search::print() prints a line of engine output, or passes it to the output
+/// hook when one is set.
+
+void Search::print(const string& line) {
+
+  if (Hooks.line)
+      Hooks.line(line);
+  else
+      sync_cout << line << sync_endl;
+}
+
 namespace {
 
   // Different node types, used as a template parameter
@@ -85,6 +101,97 @@ namespace {
     return VALUE_DRAW + Value(2 * (thisThread->nodes & 1) - 1);
   }
 
+  // SharedLines shares the PV lines of a MultiPV search between the threads.
+  // The result of a line is only valid for the first moves of the lines
+  // before it, which are stored along with it.
+  class SharedLines {
+
+    struct Line {
+      std::vector<Move> previous; // Sorted first moves of the lines before
+      bool done;
+      RootMove rm;
+    };
+
+  public:
+    enum Result { NONE, BUSY, FOUND };
+
+    void clear() {
+      std::lock_guard<std::mutex> lk(mutex);
+      lines.clear();
+      claimed.clear();
+    }
+
+    // claim() returns the next line after the given one that no thread has
+    // searched ahead yet
+    size_t claim(Depth d, size_t after) {
+      std::lock_guard<std::mutex> lk(mutex);
+      size_t& line = claimed[d];
+      line = std::max(line, after) + 1;
+      return line;
+    }
+
+    // start() marks the current line of the thread as being searched, and
+    // store() saves its result
+    void start(const Thread& th, Depth d) { update(th, d, false); }
+    void store(const Thread& th, Depth d) { update(th, d, true); }
+
+    // probe() looks for the current line of the thread. If it has been
+    // searched, its move is brought to the front of the line with the result,
+    // and the other moves of the line are scored as search() would.
+    Result probe(Thread& th, Depth d) {
+      std::vector<Move> previous = previous_moves(th);
+      std::lock_guard<std::mutex> lk(mutex);
+      Line* l = find(th, d, previous);
+      if (!l || !l->done)
+          return l ? BUSY : NONE;
+
+      auto first = th.rootMoves.begin() + th.pvIdx, last = th.rootMoves.begin() + th.pvLast;
+      auto rm = std::find(first, last, l->rm.pv[0]);
+      if (rm == last)
+          return NONE;
+
+      std::rotate(first, rm, rm + 1);
+      for (rm = first + 1; rm != last; ++rm)
+          rm->score = -VALUE_INFINITE;
+      first->score = l->rm.score;
+      first->selDepth = l->rm.selDepth;
+      first->pv = l->rm.pv;
+      return FOUND;
+    }
+
+  private:
+    static std::vector<Move> previous_moves(const Thread& th) {
+      std::vector<Move> moves;
+      for (size_t i = 0; i < th.pvIdx; ++i)
+          moves.push_back(th.rootMoves[i].pv[0]);
+      std::sort(moves.begin(), moves.end());
+      return moves;
+    }
+
+    Line* find(const Thread& th, Depth d, const std::vector<Move>& previous) {
+      for (Line& l : lines[{d, th.pvIdx}])
+          if (l.previous == previous)
+              return &l;
+      return nullptr;
+    }
+
+    void update(const Thread& th, Depth d, bool done) {
+      std::vector<Move> previous = previous_moves(th);
+      std::lock_guard<std::mutex> lk(mutex);
+      Line* l = find(th, d, previous);
+      if (!l)
+          lines[{d, th.pvIdx}].push_back({ previous, done, th.rootMoves[th.pvIdx] });
+      else if (done && !l->done)
+          l->done = true, l->rm = th.rootMoves[th.pvIdx];
+    }
+
+    std::mutex mutex;
+    std::map<std::pair<Depth, size_t>, std::vector<Line>> lines;
+    std::map<Depth, size_t> claimed;
+  };
+
+  SharedLines Lines;
+
   // Skill structure is used to implement strength limit
   struct Skill {
     explicit Skill(int l) : level(l) {}
@@ -182,6 +289,76 @@ namespace {
     return nodes;
   }
 
+  // print_pv() prints the PV lines, unless they go to the output hook
+  void print_pv(const Position& pos, Depth depth, Value alpha, Value beta) {
+
+    string pv = UCI::pv(pos, depth, alpha, beta);
+    if (!Hooks.pv)
+        sync_cout << pv << sync_endl;
+  }
+
+  // solve_mate() runs the proof-number mate solver on "go mate" and in tsume
+  // mode, where long forced mates with drops are beyond the alpha-beta search.
+  // Mates are first searched among checks only, which is the rule in tsume
+  // mode. The solver gets half of the time or node budget, the alpha-beta
+  // search uses the rest if no mate is found. Returns false if the alpha-beta
+  // search should run.
+  bool solve_mate(MainThread* th) {
+
+    // The solver does not know about restricted root moves
+    if (!Limits.searchmoves.empty() || !Limits.banmoves.empty())
+        return false;
+
+    const bool tsume = Options["TsumeMode"];
+    Mate::Limits limits;
+    limits.plies = Limits.mate ? 2 * Limits.mate - 1 : MAX_PLY - 1;
+    limits.time =  Limits.movetime ? std::max(Limits.movetime / 2, TimePoint(1))
+                 : Limits.use_time_management() ? std::max(Time.optimum() / 2, TimePoint(1)) : 0;
+
+    // Without a limit the solver would leave no time for the alpha-beta search
+    if (!Limits.mate && !limits.time && !Limits.nodes)
+        return false;
+
+    Mate::Result result = Mate::NO_MATE;
+    std::vector<Move> pv;
+    uint64_t nodes = 0;
+
+    for (bool checksOnly : { true, false })
+    {
+        if (!checksOnly && (tsume || !Limits.mate))
+            break;
+
+        uint64_t n;
+        limits.checksOnly = checksOnly;
+        limits.nodes = Limits.nodes ? uint64_t(std::max(Limits.nodes / 2 - int64_t(nodes), int64_t(1))) : 0;
+        result = Mate::solve(th->rootPos, limits, pv, n);
+        nodes += n;
+        if (result != Mate::NO_MATE)
+            break;
+    }
+
+    th->nodes = nodes;
+
+    RootMoves& rootMoves = th->rootMoves;
+    auto it = result == Mate::MATE ? std::find(rootMoves.begin(), rootMoves.end(), pv[0]) : rootMoves.end();
+    if (it != rootMoves.end())
+    {
+        std::rotate(rootMoves.begin(), it, it + 1);
+        rootMoves[0].pv = pv;
+        rootMoves[0].score = mate_in(int(pv.size()));
+        rootMoves[0].selDepth = int(pv.size());
+        th->completedDepth = int(pv.size());
+        print_pv(th->rootPos, th->completedDepth, -VALUE_INFINITE, VALUE_INFINITE);
+        return true;
+    }
+
+    if (result == Mate::NO_MATE && Limits.mate)
+        print("info string No mate in " + std::to_string(Limits.mate) + " moves");
+
+    // A disproof in tsume mode only rules out mates by checks
+    return result == Mate::NO_MATE && Limits.mate;
+  }
+
 } // namespace
 
 
@@ -203,7 +380,6 @@ void Search::clear() {
   Time.availableNodes = 0;
   TT.clear();
   Threads.clear();
-  Tablebases::init(Options["SyzygyPath"]); // Free mapped files
 }
 
 
@@ -242,14 +418,20 @@ void MainThread::search() {
                     << sync_endl;
       }
       else
-      sync_cout << "info depth 0 score "
-                << UCI::value(result)
-                << sync_endl;
+          print("info depth 0 score " + UCI::value(result));
   }
+  else if (Options["MateSolver"] && (Limits.mate || Options["TsumeMode"]) && solve_mate(this))
+  {}
   else
   {
+      Lines.clear();
       Threads.start_searching(); // start non-main threads
       Thread::search();          // main thread start searching
+
+      // With a node budget per thread the helpers stop on their own. Let them
+      // use up their budget, so that the result does not depend on timing.
+      if (Limits.threadNodes)
+          Threads.wait_for_search_finished();
   }
 
   if (rootPos.two_boards() && !Threads.abort && Options["Protocol"] == "xboard")
@@ -291,7 +473,7 @@ void MainThread::search() {
 
   // Send again PV info if we have a new best thread
   if (bestThread != this)
-      sync_cout << UCI::pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE) << sync_endl;
+      print_pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE);
 
   if (Options["Protocol"] == "xboard")
   {
@@ -312,9 +494,17 @@ void MainThread::search() {
       return;
   }
 
+  const bool hasPonder = bestThread->rootMoves[0].pv.size() > 1 || bestThread->rootMoves[0].extract_ponder_from_tt(rootPos);
+
+  if (Hooks.bestmove)
+  {
+      Hooks.bestmove(bestThread->rootMoves[0].pv[0], hasPonder ? bestThread->rootMoves[0].pv[1] : MOVE_NONE);
+      return;
+  }
+
   sync_cout << "bestmove " << UCI::move(rootPos, bestThread->rootMoves[0].pv[0]);
 
-  if (bestThread->rootMoves[0].pv.size() > 1 || bestThread->rootMoves[0].extract_ponder_from_tt(rootPos))
+  if (hasPonder)
       std::cout << " ponder " << UCI::move(rootPos, bestThread->rootMoves[0].pv[1]);
 
   std::cout << sync_endl;
@@ -402,9 +592,108 @@ void Thread::search() {
 
   int searchAgainCounter = 0;
 
+  // Searches the PV line pvIdx with an aspiration window around its score in
+  // the previous iteration
+  auto search_line = [&]() {
+
+      // Reset UCI info selDepth for each depth and each PV line
+      selDepth = 0;
+
+      // Reset aspiration window starting size
+      if (rootDepth >= 4)
+      {
+          Value prev = rootMoves[pvIdx].previousScore;
+          delta = Value(17 * (1 + rootPos.captures_to_hand()));
+          alpha = std::max(prev - delta,-VALUE_INFINITE);
+          beta  = std::min(prev + delta, VALUE_INFINITE);
+
+          // Adjust contempt based on root move's previousScore (dynamic contempt)
+          int dct = ct + (113 - ct / 2) * prev / (abs(prev) + 147);
+
+          contempt = (us == WHITE ?  make_score(dct, dct / 2)
+                                  : -make_score(dct, dct / 2));
+      }
+
+      // Start with a small aspiration window and, in the case of a fail
+      // high/low, re-search with a bigger window until we don't fail
+      // high/low anymore.
+      failedHighCnt = 0;
+      while (true)
+      {
+          Depth adjustedDepth = std::max(1, rootDepth - failedHighCnt - searchAgainCounter);
+          bestValue = ::search<PV>(rootPos, ss, alpha, beta, adjustedDepth, false);
+
+          // Bring the best move to the front. It is critical that sorting
+          // is done with a stable algorithm because all the values but the
+          // first and eventually the new best one are set to -VALUE_INFINITE
+          // and we want to keep the same order for all the moves except the
+          // new PV that goes to the front. Note that in case of MultiPV
+          // search the already searched PV lines are preserved.
+          std::stable_sort(rootMoves.begin() + pvIdx, rootMoves.begin() + pvLast);
+
+          // If search has been stopped, we break immediately. Sorting is
+          // safe because RootMoves is still valid, although it refers to
+          // the previous iteration.
+          if (stopped())
+              break;
+
+          // When failing high/low give some update (without cluttering
+          // the UI) before a re-search.
+          if (   mainThread
+              && multiPV == 1
+              && (bestValue <= alpha || bestValue >= beta)
+              && Time.elapsed() > 3000)
+              print_pv(rootPos, rootDepth, alpha, beta);
+
+          // In case of failing low/high increase aspiration window and
+          // re-search, otherwise exit the loop.
+          if (bestValue <= alpha)
+          {
+              beta = (alpha + beta) / 2;
+              alpha = std::max(bestValue - delta, -VALUE_INFINITE);
+
+              failedHighCnt = 0;
+              if (mainThread)
+                  mainThread->stopOnPonderhit = false;
+          }
+          else if (bestValue >= beta)
+          {
+              beta = std::min(bestValue + delta, VALUE_INFINITE);
+              ++failedHighCnt;
+          }
+          else
+              break;
+
+          delta += delta / 4 + 5;
+
+          assert(alpha >= -VALUE_INFINITE && beta <= VALUE_INFINITE);
+      }
+  };
+
+  // Searches a later PV line for the other threads, with the first moves of
+  // the lines before as they are now, mostly from the previous iteration
+  auto search_ahead = [&](size_t line) {
+
+      size_t current = pvIdx, last = pvLast;
+
+      pvIdx = line;
+      for (pvLast = pvIdx + 1; pvLast < rootMoves.size(); pvLast++)
+          if (rootMoves[pvLast].tbRank != rootMoves[pvIdx].tbRank)
+              break;
+
+      Lines.start(*this, rootDepth);
+      search_line();
+
+      if (!stopped())
+          Lines.store(*this, rootDepth);
+
+      pvIdx = current;
+      pvLast = last;
+  };
+
   // Iterative deepening loop until requested to stop or the target depth is reached
   while (   ++rootDepth < MAX_PLY
-         && !Threads.stop
+         && !stopped()
          && !(Limits.depth && mainThread && rootDepth > Limits.depth))
   {
       // Age out PV variability metric
@@ -417,13 +706,20 @@ void Thread::search() {
           rm.previousScore = rm.score;
 
       size_t pvFirst = 0;
-      pvLast = 0;
 
       if (!Threads.increaseDepth)
          searchAgainCounter++;
 
+      // Helper threads first search later PV lines ahead, so that the threads
+      // split the lines between them
+      if (!mainThread && multiPV > 1 && rootDepth > 1)
+          for (size_t line; (line = Lines.claim(rootDepth, 0)) < multiPV && !stopped(); )
+              search_ahead(line);
+
+      pvLast = 0;
+
       // MultiPV loop. We perform a full root search for each PV line
-      for (pvIdx = 0; pvIdx < multiPV && !Threads.stop; ++pvIdx)
+      for (pvIdx = 0; pvIdx < multiPV && !stopped(); ++pvIdx)
       {
           if (pvIdx == pvLast)
           {
@@ -433,88 +729,44 @@ void Thread::search() {
                       break;
           }
 
-          // Reset UCI info selDepth for each depth and each PV line
-          selDepth = 0;
-
-          // Reset aspiration window starting size
-          if (rootDepth >= 4)
+          // Take the result of the line if another thread has already searched
+          // it with the same lines before. While another thread is searching
+          // it, search later lines ahead rather than the same line.
+          SharedLines::Result shared = SharedLines::NONE;
+          for (size_t line; multiPV > 1 && !stopped(); )
           {
-              Value prev = rootMoves[pvIdx].previousScore;
-              delta = Value(17 * (1 + rootPos.captures_to_hand()));
-              alpha = std::max(prev - delta,-VALUE_INFINITE);
-              beta  = std::min(prev + delta, VALUE_INFINITE);
-
-              // Adjust contempt based on root move's previousScore (dynamic contempt)
-              int dct = ct + (113 - ct / 2) * prev / (abs(prev) + 147);
-
-              contempt = (us == WHITE ?  make_score(dct, dct / 2)
-                                      : -make_score(dct, dct / 2));
+              shared = Lines.probe(*this, rootDepth);
+              if (shared != SharedLines::BUSY || (line = Lines.claim(rootDepth, pvIdx)) >= multiPV)
+                  break;
+              search_ahead(line);
           }
 
-          // Start with a small aspiration window and, in the case of a fail
-          // high/low, re-search with a bigger window until we don't fail
-          // high/low anymore.
-          failedHighCnt = 0;
-          while (true)
+          if (shared == SharedLines::FOUND)
           {
-              Depth adjustedDepth = std::max(1, rootDepth - failedHighCnt - searchAgainCounter);
-              bestValue = ::search<PV>(rootPos, ss, alpha, beta, adjustedDepth, false);
-
-              // Bring the best move to the front. It is critical that sorting
-              // is done with a stable algorithm because all the values but the
-              // first and eventually the new best one are set to -VALUE_INFINITE
-              // and we want to keep the same order for all the moves except the
-              // new PV that goes to the front. Note that in case of MultiPV
-              // search the already searched PV lines are preserved.
-              std::stable_sort(rootMoves.begin() + pvIdx, rootMoves.begin() + pvLast);
-
-              // If search has been stopped, we break immediately. Sorting is
-              // safe because RootMoves is still valid, although it refers to
-              // the previous iteration.
-              if (Threads.stop)
-                  break;
-
-              // When failing high/low give some update (without cluttering
-              // the UI) before a re-search.
-              if (   mainThread
-                  && multiPV == 1
-                  && (bestValue <= alpha || bestValue >= beta)
-                  && Time.elapsed() > 3000)
-                  sync_cout << UCI::pv(rootPos, rootDepth, alpha, beta) << sync_endl;
-
-              // In case of failing low/high increase aspiration window and
-              // re-search, otherwise exit the loop.
-              if (bestValue <= alpha)
-              {
-                  beta = (alpha + beta) / 2;
-                  alpha = std::max(bestValue - delta, -VALUE_INFINITE);
-
-                  failedHighCnt = 0;
-                  if (mainThread)
-                      mainThread->stopOnPonderhit = false;
-              }
-              else if (bestValue >= beta)
-              {
-                  beta = std::min(bestValue + delta, VALUE_INFINITE);
-                  ++failedHighCnt;
-              }
-              else
-                  break;
+              bestValue = rootMoves[pvIdx].score;
+              alpha = -VALUE_INFINITE;
+              beta = VALUE_INFINITE;
+          }
+          else
+          {
+              if (multiPV > 1)
+                  Lines.start(*this, rootDepth);
 
-              delta += delta / 4 + 5;
+              search_line();
 
-              assert(alpha >= -VALUE_INFINITE && beta <= VALUE_INFINITE);
+              if (multiPV > 1 && !stopped())
+                  Lines.store(*this, rootDepth);
           }
 
           // Sort the PV lines searched so far and update the GUI
           std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
           if (    mainThread
-              && (Threads.stop || pvIdx + 1 == multiPV || Time.elapsed() > 3000))
-              sync_cout << UCI::pv(rootPos, rootDepth, alpha, beta) << sync_endl;
+              && (stopped() || pvIdx + 1 == multiPV || Time.elapsed() > 3000))
+              print_pv(rootPos, rootDepth, alpha, beta);
       }
 
-      if (!Threads.stop)
+      if (!stopped())
           completedDepth = rootDepth;
 
       if (rootMoves[0].pv[0] != lastBestMove) {
@@ -695,8 +947,12 @@ namespace {
         if (pos.is_game_end(variantResult, ss->ply))
             return variantResult;
 
+        // Neither side has mating material left
+        if (pos.is_material_draw())
+            return value_draw(pos.this_thread());
+
         // Step 2. Check for aborted search and immediate draw
-        if (   Threads.stop.load(std::memory_order_relaxed)
+        if (   thisThread->stopped()
             || ss->ply >= MAX_PLY)
             return (ss->ply >= MAX_PLY && !ss->inCheck) ? evaluate(pos)
                                                         : value_draw(pos.this_thread());
@@ -1089,9 +1345,9 @@ moves_loop: // When in check, search starts from here
 
       if (rootNode && thisThread == Threads.main() && Time.elapsed() > 3000 && Options["Protocol"] != "xboard"
           && !Limits.silent)
-          sync_cout << "info depth " << depth
-                    << " currmove " << UCI::move(pos, move)
-                    << " currmovenumber " << moveCount + thisThread->pvIdx << sync_endl;
+          print(  "info depth " + std::to_string(depth)
+                + " currmove " + UCI::move(pos, move)
+                + " currmovenumber " + std::to_string(moveCount + thisThread->pvIdx));
       if (PvNode)
           (ss+1)->pv = nullptr;
 
@@ -1379,7 +1635,7 @@ moves_loop: // When in check, search starts from here
       // Finished searching the move. If a stop occurred, the return value of
       // the search cannot be trusted, and we return immediately without
       // updating best move, PV and TT.
-      if (Threads.stop.load(std::memory_order_relaxed))
+      if (thisThread->stopped())
           return VALUE_ZERO;
 
       if (rootNode)
@@ -1538,6 +1794,9 @@ moves_loop: // When in check, search starts from here
     if (pos.is_game_end(gameResult, ss->ply))
         return gameResult;
 
+    if (pos.is_material_draw())
+        return value_draw(pos.this_thread());
+
     // Check for maximum ply reached
     if (ss->ply >= MAX_PLY)
         return !ss->inCheck ? evaluate(pos) : VALUE_DRAW;
@@ -1965,6 +2224,7 @@ void MainThread::check_time() {
 
 /// UCI::pv() formats PV information according to the UCI protocol. UCI requires
 /// that all (if any) unsearched PV lines are sent using a previous search score.
+/// Each line is also passed to the PV output hook, if one is set.
 
 string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
 
@@ -1995,6 +2255,8 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
       if (ss.rdbuf()->in_avail()) // Not at first line
           ss << "\n";
 
+      const auto lineStart = ss.tellp();
+
       if (Options["Protocol"] == "xboard")
       {
           ss << d << " "
@@ -2035,6 +2297,10 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
       for (Move m : rootMoves[i].pv)
           ss << " " << UCI::move(pos, m);
       }
+
+      if (Hooks.pv)
+          Hooks.pv({ d, rootMoves[i].selDepth, i + 1, v, nodesSearched, nodesSearched * 1000 / elapsed,
+                     elapsed, rootMoves[i].pv, ss.str().substr(size_t(lineStart)) });
   }
 
   return ss.str();
@@ -2129,6 +2395,9 @@ namespace Search
 
   // Initialization for learning.
   // Called from Learner::search(),Learner::qsearch().
+  // The settings from the options are kept in the learner context of the
+  // thread and only read again after an option has been set, since looking
+  // them up takes a noticeable share of the time of small searches.
   static void init_for_search(Position& pos, Stack* ss)
   {
 
@@ -2137,64 +2406,110 @@ namespace Search
 
     std::memset(ss - 7, 0, 10 * sizeof(Stack));
 
-    // Regarding this_thread.
+    auto th = pos.this_thread();
+    auto& ctx = th->learner;
 
+    if (ctx.optionsVersion != UCI::OptionsVersion || ctx.infinite != Limits.infinite)
     {
-      auto th = pos.this_thread();
+      ctx.optionsVersion = UCI::OptionsVersion;
+      ctx.infinite = Limits.infinite;
 
-      th->completedDepth = 0;
-      th->selDepth = 0;
-      th->rootDepth = 0;
-      th->nmpMinPly = th->bestMoveChanges = 0;
-      th->ttHitAverage = TtHitAverageWindow * TtHitAverageResolution / 2;
+      for (Color us : { WHITE, BLACK })
+      {
+        int ct = int(Options["Contempt"]) * PawnValueEg / 100; // From centipawns
 
-      // Zero initialization of the number of search nodes
-      th->nodes = 0;
+        // In analysis mode, adjust contempt in accordance with user preference
+        if (Limits.infinite || Options["UCI_AnalyseMode"])
+          ct = Options["Analysis Contempt"] == "Off" ? 0
+          : Options["Analysis Contempt"] == "Both" ? ct
+          : Options["Analysis Contempt"] == "White" && us == BLACK ? -ct
+          : Options["Analysis Contempt"] == "Black" && us == WHITE ? -ct
+          : ct;
 
-      // Clear all history types. This initialization takes a little time, and the accuracy of the search is rather low, so the good and bad are not well understood.
-      // th->clear();
+        // Evaluation score is from the white point of view
+        ctx.contempt[us] = (us == WHITE ? make_score(ct, ct / 2)
+          : -make_score(ct, ct / 2));
+      }
 
-      int ct = int(Options["Contempt"]) * PawnValueEg / 100; // From centipawns
-      Color us = pos.side_to_move();
+      ctx.useRule50 = bool(Options["Syzygy50MoveRule"]);
+      ctx.probeDepth = int(Options["SyzygyProbeDepth"]);
+      ctx.cardinality = int(Options["SyzygyProbeLimit"]);
 
-      // In analysis mode, adjust contempt in accordance with user preference
-      if (Limits.infinite || Options["UCI_AnalyseMode"])
-        ct = Options["Analysis Contempt"] == "Off" ? 0
-        : Options["Analysis Contempt"] == "Both" ? ct
-        : Options["Analysis Contempt"] == "White" && us == BLACK ? -ct
-        : Options["Analysis Contempt"] == "Black" && us == WHITE ? -ct
-        : ct;
+      // Tables with fewer pieces than SyzygyProbeLimit are searched with
+      // ProbeDepth == DEPTH_ZERO
+      if (ctx.cardinality > Tablebases::MaxCardinality)
+      {
+          ctx.cardinality = Tablebases::MaxCardinality;
+          ctx.probeDepth = 0;
+      }
+    }
 
-      // Evaluation score is from the white point of view
-      th->contempt = (us == WHITE ? make_score(ct, ct / 2)
-        : -make_score(ct, ct / 2));
+    // Regarding this_thread.
 
-      for (int i = 7; i > 0; i--)
-          (ss - i)->continuationHistory = &th->continuationHistory[0][0][NO_PIECE][0]; // Use as a sentinel
+    th->completedDepth = 0;
+    th->selDepth = 0;
+    th->rootDepth = 0;
+    th->nmpMinPly = th->bestMoveChanges = 0;
+    th->ttHitAverage = TtHitAverageWindow * TtHitAverageResolution / 2;
 
-      // set rootMoves
-      auto& rootMoves = th->rootMoves;
+    // Zero initialization of the number of search nodes
+    th->nodes = 0;
+    th->nodesLimit = 0;
 
-      rootMoves.clear();
-      for (auto m: MoveList<LEGAL>(pos))
-        rootMoves.push_back(Search::RootMove(m));
+    // Clear all history types. This initialization takes a little time, and the accuracy of the search is rather low, so the good and bad are not well understood.
+    // th->clear();
 
-      assert(!rootMoves.empty());
+    th->contempt = ctx.contempt[pos.side_to_move()];
 
-      th->UseRule50 = bool(Options["Syzygy50MoveRule"]);
-      th->ProbeDepth = int(Options["SyzygyProbeDepth"]);
-      th->Cardinality = int(Options["SyzygyProbeLimit"]);
+    for (int i = 7; i > 0; i--)
+        (ss - i)->continuationHistory = &th->continuationHistory[0][0][NO_PIECE][0]; // Use as a sentinel
 
-      // Tables with fewer pieces than SyzygyProbeLimit are searched with
-      // ProbeDepth == DEPTH_ZERO
-      if (th->Cardinality > Tablebases::MaxCardinality)
+    th->UseRule50 = ctx.useRule50;
+    th->ProbeDepth = ctx.probeDepth;
+    th->Cardinality = ctx.cardinality;
+  }
+
+  // Sets up the root moves for search(). qsearch() does not need them. The
+  // root moves of the previous call are reused, so that their PVs are not
+  // allocated again for every position.
+  static void init_root_moves(Position& pos)
+  {
+    auto& rootMoves = pos.this_thread()->rootMoves;
+    MoveList<LEGAL> moves(pos);
+
+    for (size_t i = 0; i < moves.size(); ++i)
+    {
+      if (i == rootMoves.size())
       {
-          th->Cardinality = Tablebases::MaxCardinality;
-          th->ProbeDepth = 0;
+        rootMoves.emplace_back(moves.at(i));
+        continue;
       }
 
-      Tablebases::rank_root_moves(pos, rootMoves);
+      RootMove& rm = rootMoves[i];
+      rm.pv.resize(1);
+      rm.pv[0] = moves.at(i);
+      rm.score = rm.previousScore = -VALUE_INFINITE;
+      rm.selDepth = 0;
+      rm.tbRank = 0;
     }
+    rootMoves.erase(rootMoves.begin() + moves.size(), rootMoves.end());
+
+    assert(!rootMoves.empty());
+
+    Tablebases::rank_root_moves(pos, rootMoves);
+  }
+
+  // Whether the side to move has a legal move, as MoveList<LEGAL> would
+  // tell, but without testing the legality of all moves
+  static bool has_legal_move(const Position& pos)
+  {
+    if (pos.is_immediate_game_end())
+      return false;
+
+    ExtMove moves[MAX_MOVES];
+    ExtMove* last = pos.checkers() ? generate<EVASIONS>(pos, moves)
+                                   : generate<NON_EVASIONS>(pos, moves);
+    return std::any_of(moves, last, [&](const ExtMove& m) { return pos.legal(m); });
   }
 
   // Stationary search.
@@ -2222,7 +2537,7 @@ namespace Search
       return { v, {} };
 
     // Is it stuck?
-    if (MoveList<LEGAL>(pos).size() == 0)
+    if (!has_legal_move(pos))
     {
       // Return the mated value if checkmated.
       return { mated_in(/*ss->ply*/ 0 + 1), {} }; // TODO: checkmate value
@@ -2249,12 +2564,20 @@ namespace Search
   // Declaration win judgment is not done as root (because it is troublesome to handle), so it is not done here.
   // Handle it by the caller.
   //
+  // If multiPVDepth is non-zero, only the best line is deepened beyond multiPVDepth.
+  // The other lines keep the score of the last iteration they were searched in,
+  // which allows a single search to give both a deep score and a shallower set of candidates.
+  //
+  // If nodesLimit is non-zero, the search stops as soon as this thread has searched
+  // nodesLimit * multiPV nodes, also in the middle of an iteration. The first iteration
+  // is always completed so that there is a valid result.
+  //
   // Precondition) Search thread is set by pos.set_this_thread(Threads[thread_id]).
   // Also, when Threads.stop arrives, the search is interrupted, so the PV at that time is not correct.
   // After returning from search(), if Threads.stop == true, do not use the search result.
   // Also, note that before calling, if you do not call it with Threads.stop == false, the search will be interrupted and it will return.
 
-  ValueAndPV search(Position& pos, int depth_, size_t multiPV /* = 1 */, uint64_t nodesLimit /* = 0 */)
+  ValueAndPV search(Position& pos, int depth_, size_t multiPV /* = 1 */, uint64_t nodesLimit /* = 0 */, int multiPVDepth /* = 0 */)
   {
     std::vector<Move> pvs;
 
@@ -2263,12 +2586,18 @@ namespace Search
       return std::pair<Value, std::vector<Move>>(Eval::evaluate(pos), std::vector<Move>());
 
     if (depth == 0)
-      return qsearch(pos);
+    {
+      // Callers may look at the root moves, as after deeper searches
+      ValueAndPV result = qsearch(pos);
+      init_root_moves(pos);
+      return result;
+    }
 
     Stack stack[MAX_PLY + 10], * ss = stack + 7;
     Move pv[MAX_PLY + 1];
 
     init_for_search(pos, ss);
+    init_root_moves(pos);
 
 	ss->pv = pv; // For the time being, it must be a dummy and somewhere with a buffer.
 
@@ -2295,11 +2624,7 @@ namespace Search
     Value delta = -VALUE_INFINITE;
     Value bestValue = -VALUE_INFINITE;
 
-    while ((rootDepth += 1) <= depth
-      // exit this loop even if the node limit is exceeded
-      // The number of search nodes is passed in the argument of this function.
-      && !(nodesLimit /* limited nodes */ && th->nodes.load(std::memory_order_relaxed) >= nodesLimit)
-      )
+    while ((rootDepth += 1) <= depth && !th->stopped())
     {
       for (RootMove& rm : rootMoves)
         rm.previousScore = rm.score;
@@ -2307,8 +2632,11 @@ namespace Search
       size_t pvFirst = 0;
       pvLast = 0;
 
+      // Beyond multiPVDepth only the best line is searched
+      const size_t pvCount = multiPVDepth && rootDepth > multiPVDepth ? 1 : multiPV;
+
       // MultiPV loop. We perform a full root search for each PV line
-      for (pvIdx = 0; pvIdx < multiPV && !Threads.stop; ++pvIdx)
+      for (pvIdx = 0; pvIdx < pvCount && !th->stopped(); ++pvIdx)
       {
         if (pvIdx == pvLast)
         {
@@ -2338,6 +2666,9 @@ namespace Search
           stable_sort(rootMoves.begin() + pvIdx, rootMoves.end());
           //my_stable_sort(pos.this_thread()->thread_id(),&rootMoves[0] + pvIdx, rootMoves.size() - pvIdx);
 
+          if (th->stopped())
+            break;
+
           // Expand aspiration window for fail low/high.
           // However, if it is the value specified by the argument, it will be treated as fail low/high and break.
           if (bestValue <= alpha)
@@ -2364,7 +2695,21 @@ namespace Search
 
       } // multi PV
 
-      completedDepth = rootDepth;
+      // Restore the scores of the lines that were not searched in this iteration
+      if (pvCount < multiPV)
+      {
+        for (size_t i = 1; i < rootMoves.size(); ++i)
+          if (rootMoves[i].score == -VALUE_INFINITE)
+            rootMoves[i].score = rootMoves[i].previousScore;
+
+        stable_sort(rootMoves.begin() + 1, rootMoves.end());
+      }
+
+      if (!th->stopped())
+        completedDepth = rootDepth;
+
+      // The node budget of this thread is checked at every node from the second iteration on
+      th->nodesLimit = nodesLimit;
     }
 
     // Pass PV_is(ok) to eliminate this PV, there may be NULL_MOVE in the middle.
@@ -19,6 +19,8 @@
 #ifndef SEARCH_H_INCLUDED
 #define SEARCH_H_INCLUDED
 
+#include <functional>
+#include <string>
 #include <vector>
 
 #include "misc.h"
@@ -88,7 +90,7 @@ struct LimitsType {
   LimitsType() { // Init explicitly due to broken value-initialization of non POD in MSVC
     time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
     movestogo = depth = mate = perft = infinite = 0;
-    nodes = 0;
+    nodes = threadNodes = 0;
     silent = false;
   }
 
@@ -99,7 +101,7 @@ struct LimitsType {
   std::vector<Move> searchmoves, banmoves;
   TimePoint time[COLOR_NB], inc[COLOR_NB], npmsec, movetime, startTime;
   int movestogo, depth, mate, perft, infinite;
-  int64_t nodes;
+  int64_t nodes, threadNodes;
   // Silent mode that does not output to the screen (for continuous self-play in process)
   // Do not output PV at this time.
   bool silent;
@@ -107,14 +109,53 @@ struct LimitsType {
 
 extern LimitsType Limits;
 
+/// PVLine is a line of PV output of the main thread, with the score from the
+/// point of view of the side to move and the line as it is printed.
+struct PVLine {
+  Depth depth, selDepth;
+  size_t multiPV;
+  Value score;
+  uint64_t nodes, nps;
+  TimePoint time;
+  const std::vector<Move>& pv;
+  const std::string& text;
+};
+
+/// OutputHooks receive the output of the search instead of std::cout when they
+/// are set, so that a program embedding the engine gets the moves and scores
+/// without parsing UCI text. Other lines, e.g., "info string", are passed as
+/// text, also those printed outside a search, e.g., when loading a net. The
+/// hooks are called from the threads producing the output.
+struct OutputHooks {
+  std::function<void(const PVLine&)> pv;
+  std::function<void(const std::string&)> line;
+  std::function<void(Move best, Move ponder)> bestmove;
+};
+
+extern OutputHooks Hooks;
+
+void print(const std::string& line);
+
 void init();
 void clear();
 
 // A pair of reader and evaluation value. Returned by Learner::search(),Learner::qsearch().
 using ValueAndPV = std::pair<Value, std::vector<Move>>;
 
+/// LearnerContext keeps the state of the qsearch() and search() calls of one
+/// thread between calls. The settings from the options are only read again
+/// after an option has been set, and the root moves are reused.
+struct LearnerContext {
+  uint64_t optionsVersion = 0;
+  int infinite;             // Limits.infinite when the options were read
+  Score contempt[COLOR_NB]; // For each side to move
+  bool useRule50;
+  Depth probeDepth;
+  int cardinality;
+};
+
 ValueAndPV qsearch(Position& pos);
-ValueAndPV search(Position& pos, int depth_, size_t multiPV = 1, uint64_t nodesLimit = 0);
+ValueAndPV search(Position& pos, int depth_, size_t multiPV = 1, uint64_t nodesLimit = 0, int multiPVDepth = 0);
 
 }
 
@@ -0,0 +1,213 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "misc.h"
+#include "search.h"
+#include "server.h"
+#include "thread.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace {
+
+  // Parse a decimal number that has to cover the whole token. Returns false
+  // for malformed or out of range numbers.
+  bool parse_number(const string& token, long minValue, long maxValue, long& value) {
+
+    char* end;
+    errno = 0;
+    value = strtol(token.c_str(), &end, 10);
+    return   end != token.c_str() && !*end && errno != ERANGE
+          && value >= minValue && value <= maxValue;
+  }
+
+#if !defined(_WIN32)
+
+  // Open a listening socket, either a Unix domain socket at the given path
+  // or a TCP socket bound to the loopback interface at the given port.
+  int open_socket(const string& family, const string& address) {
+
+    int fd = -1;
+
+    if (family == "unix")
+    {
+        sockaddr_un addr;
+        if (address.size() >= sizeof(addr.sun_path))
+            return -1;
+
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, address.c_str());
+        unlink(address.c_str()); // Remove a stale socket of a previous server
+
+        if (   (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+            || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+    else if (family == "tcp")
+    {
+        long port;
+        if (!parse_number(address, 1, 65535, port))
+        {
+            errno = EINVAL;
+            return -1;
+        }
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        int reuse = 1;
+        if (   (fd = socket(AF_INET, SOCK_STREAM, 0)) < 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0
+            || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+
+    return fd >= 0 && listen(fd, SOMAXCONN) == 0 ? fd : -1;
+  }
+
+  // Reap finished sessions, blocking until one ends if requested
+  void reap_sessions(int& sessions, bool block) {
+
+    while (sessions > 0 && waitpid(-1, nullptr, block ? 0 : WNOHANG) > 0)
+    {
+        --sessions;
+        block = false;
+    }
+  }
+
+#endif
+
+} // namespace
+
+
+/// Server::run() is called for "server unix <path>" or "server tcp <port>" on
+/// the command line. The optional parameters threads, hash and sessions give
+/// the default share of each session and the maximum number of concurrent
+/// sessions, e.g. "server unix /tmp/fairy.sock threads 2 hash 64 sessions 16".
+/// Each session may still change its own options via setoption.
+
+void Server::run(int argc, char* argv[]) {
+
+  string args, family, address, token;
+  for (int i = 2; i < argc; ++i)
+      args += string(argv[i]) + " ";
+
+  istringstream is(args);
+  is >> family >> address;
+
+  // Threads and hash are clamped to the range of their options by set_default()
+  long maxSessions = 0, value; // 0 means unlimited
+  while (is >> token)
+  {
+      string name = token;
+      if (!(is >> token))
+          break;
+
+      if (!parse_number(token, 0, LONG_MAX, value))
+          sync_cout << "info string Invalid " << name << " " << token << sync_endl;
+      else if (name == "threads")
+          Options["Threads"].set_default(to_string(value));
+      else if (name == "hash")
+          Options["Hash"].set_default(to_string(value));
+      else if (name == "sessions")
+          maxSessions = value;
+  }
+
+#if defined(_WIN32)
+
+  sync_cout << "info string Server mode is not supported on this platform" << sync_endl;
+
+#else
+
+  int listenFd = open_socket(family, address);
+  if (listenFd < 0)
+  {
+      sync_cout << "info string Failed to listen on " << family << " " << address
+                << ": " << strerror(errno) << sync_endl;
+      return;
+  }
+
+  // Threads can not survive fork(), so each session starts its own pool
+  Threads.set(0);
+
+  sync_cout << "info string Listening on " << family << " " << address << sync_endl;
+
+  int sessions = 0;
+  while (true)
+  {
+      reap_sessions(sessions, maxSessions && sessions >= maxSessions);
+
+      int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0)
+      {
+          if (errno == EINTR)
+              continue;
+          break;
+      }
+
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+          // Session process: the connection becomes stdin/stdout of the engine
+          close(listenFd);
+          dup2(fd, STDIN_FILENO);
+          dup2(fd, STDOUT_FILENO);
+          close(fd);
+          signal(SIGPIPE, SIG_IGN); // A closed connection ends the session at the next read
+
+          Threads.set(size_t(Options["Threads"])); // Also allocates the session hash
+          Search::clear();
+
+          char* sessionArgv[] = { argv[0], nullptr };
+          UCI::loop(1, sessionArgv);
+          return;
+      }
+
+      close(fd);
+      if (pid > 0)
+          ++sessions;
+  }
+
+  sync_cout << "info string Server stopped: " << strerror(errno) << sync_endl;
+  close(listenFd);
+
+#endif
+}
@@ -0,0 +1,35 @@
+/*
+  Fairy-Stockfish, a UCI chess variant playing engine derived from Stockfish
+  Copyright (C) 2018-2021 Fabian Fichter
+
+  Fairy-Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Fairy-Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+namespace Server {
+
+/// run() listens on a Unix domain socket or a local TCP port and serves each
+/// connection as an independent UCI/USI/XBoard session. Sessions are forked
+/// from the fully initialized engine, so they share the read-only NNUE weights,
+/// attack tables and variant definitions, and only allocate their own threads
+/// and transposition table. Returns in the session processes once the session
+/// has ended, and in the server process only on errors.
+
+void run(int argc, char* argv[]);
+
+} // namespace Server
+
+#endif // #ifndef SERVER_H_INCLUDED
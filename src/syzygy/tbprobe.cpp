@@ -173,6 +173,7 @@ class TBFile : public std::ifstream {
     std::string fname;
 
 public:
+    uint64_t size = 0; // Size of the mapped file
     // Look for and open the file among the Paths directories where the .rtbw
     // and .rtbz files can be found. Multiple directories are separated by ";"
     // on Windows and by ":" on Unix-based operating systems.
@@ -222,6 +223,7 @@ public:
             exit(EXIT_FAILURE);
         }
 
+        size = statbuf.st_size;
         *mapping = statbuf.st_size;
         *baseAddress = mmap(nullptr, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
 #if defined(MADV_RANDOM)
@@ -251,6 +253,7 @@ public:
             exit(EXIT_FAILURE);
         }
 
+        size = (uint64_t(size_high) << 32) | size_low;
         HANDLE mmap = CreateFileMapping(fd, nullptr, PAGE_READONLY, size_high, size_low, nullptr);
         CloseHandle(fd);
 
@@ -337,6 +340,7 @@ struct TBTable {
     void* baseAddress;
     uint8_t* map;
     uint64_t mapping;
+    uint64_t mappedSize;
     Key key;
     Key key2;
     int pieceCount;
@@ -349,7 +353,7 @@ struct TBTable {
         return &items[stm % Sides][hasPawns ? f : 0];
     }
 
-    TBTable() : ready(false), baseAddress(nullptr) {}
+    TBTable() : ready(false), baseAddress(nullptr), mappedSize(0) {}
     explicit TBTable(const std::string& code);
     explicit TBTable(const TBTable<WDL>& wdl);
 
@@ -466,6 +470,19 @@ public:
     }
     size_t size() const { return wdlTable.size(); }
     void add(const std::vector<PieceType>& pieces);
+
+    // Bytes of the mapped files and their number
+    uint64_t mapped_bytes(size_t& files) const {
+        uint64_t bytes = 0;
+        files = 0;
+        auto count = [&](const auto& table) {
+            if (table.ready.load(std::memory_order_acquire) && table.baseAddress)
+                bytes += table.mappedSize, ++files;
+        };
+        for (const auto& t : wdlTable) count(t);
+        for (const auto& t : dtzTable) count(t);
+        return bytes;
+    }
 };
 
 TBTables TBTables;
@@ -1160,10 +1177,14 @@ void* mapped(TBTable<Type>& e, const Position& pos) {
     fname =  (e.key == pos.material_key() ? w + 'v' + b : b + 'v' + w)
            + (Type == WDL ? ".rtbw" : ".rtbz");
 
-    uint8_t* data = TBFile(fname).map(&e.baseAddress, &e.mapping, Type);
+    TBFile file(fname);
+    uint8_t* data = file.map(&e.baseAddress, &e.mapping, Type);
 
     if (data)
+    {
+        e.mappedSize = file.size;
         set(e, data);
+    }
 
     e.ready.store(true, std::memory_order_release);
     return e.baseAddress;
@@ -1261,10 +1282,29 @@ WDLScore search(Position& pos, ProbeState* result) {
 } // namespace
 
 
+/// Tablebases::memory_usage() adds the table index and the mapped files to the
+/// memory report. The files are mapped read-only, so their pages are shared
+/// with other processes using the same files.
+void Tablebases::memory_usage(std::vector<MemoryUsage>& usage) {
+
+    if (!TBTables.size())
+        return;
+
+    size_t files;
+    uint64_t bytes = TBTables.mapped_bytes(files);
+
+    usage.push_back({ "Syzygy table index", sizeof(TBTables) + TBTables.size() * (sizeof(TBTable<WDL>) + sizeof(TBTable<DTZ>)) });
+    usage.push_back({ "Syzygy mapped files (shared)", size_t(bytes), 0, files });
+}
+
 /// Tablebases::init() is called at startup and after every change to
 /// "SyzygyPath" UCI option to (re)create the various tables. It is not thread
 /// safe, nor it needs to be.
-void Tablebases::init(const std::string& paths) {
+void Tablebases::init(const std::string& paths, bool force) {
+
+    // Keep the files mapped unless the paths changed or a rescan is forced
+    if (!force && paths == TBFile::Paths)
+        return;
 
     TBTables.clear();
     MaxCardinality = 0;
@@ -1410,7 +1450,7 @@ void Tablebases::init(const std::string& paths) {
         }
     }
 
-    sync_cout << "info string Found " << TBTables.size() << " tablebases" << sync_endl;
+    Search::print("info string Found " + std::to_string(TBTables.size()) + " tablebases");
 }
 
 // Probe the WDL table for a particular position.
@@ -45,7 +45,8 @@ enum ProbeState {
 
 extern int MaxCardinality;
 
-void init(const std::string& paths);
+void init(const std::string& paths, bool force = false);
+void memory_usage(std::vector<MemoryUsage>& usage);
 WDLScore probe_wdl(Position& pos, ProbeState* result);
 int probe_dtz(Position& pos, ProbeState* result);
 bool root_probe(Position& pos, Search::RootMoves& rootMoves);
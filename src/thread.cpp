@@ -17,9 +17,12 @@
 */
 
 #include <cassert>
+#include <cstring>
+#include <iostream>
 
 #include <algorithm> // For std::count
 #include "movegen.h"
+#include "nnue/evaluate_nnue.h"
 #include "search.h"
 #include "thread.h"
 #include "uci.h"
@@ -50,6 +53,38 @@ Thread::~Thread() {
   exit = true;
   start_searching();
   stdThread.join();
+  aligned_large_pages_free(tablesMem);
+}
+
+
+/// Thread::allocate_tables() allocates the pawn and material hash tables as one
+/// block of large pages, if possible. It is called by the thread itself, so on
+/// NUMA systems the memory is first touched by, and local to, its own node.
+
+void Thread::allocate_tables() {
+
+  constexpr size_t size = Pawns::Table::Bytes + Material::Table::Bytes;
+
+  tablesMem = aligned_large_pages_alloc(size);
+  if (!tablesMem)
+  {
+      std::cerr << "Failed to allocate " << size / 1024
+                << "KB for the pawn and material tables." << std::endl;
+      std::exit(EXIT_FAILURE);
+  }
+
+  std::memset(tablesMem, 0, size);
+  pawnsTable.attach(tablesMem);
+  materialTable.attach(static_cast<char*>(tablesMem) + Pawns::Table::Bytes);
+}
+
+
+/// Thread::clear_tables() drops all cached pawn and material entries. They
+/// hold evaluation terms, so they must be cleared when eval parameters change.
+
+void Thread::clear_tables() {
+
+  std::memset(tablesMem, 0, Pawns::Table::Bytes + Material::Table::Bytes);
 }
 
 
@@ -107,6 +142,16 @@ void Thread::wait_for_worker_finished() {
   cv.wait(lk, [&]{ return !searching; });
 }
 
+
+/// Thread::is_searching() returns whether the thread is searching, without
+/// waiting for it.
+
+bool Thread::is_searching() {
+
+  std::lock_guard<std::mutex> lk(mutex);
+  return searching;
+}
+
 /// Thread::idle_loop() is where the thread is parked, blocked on the
 /// condition variable, when it has no work to do.
 
@@ -120,6 +165,8 @@ void Thread::idle_loop() {
   if (Options["Threads"] > 8)
       WinProcGroup::bindThisThread(idx);
 
+  allocate_tables();
+
   while (true)
   {
       std::unique_lock<std::mutex> lk(mutex);
@@ -148,6 +195,9 @@ void Thread::idle_loop() {
       else
       {
         search();
+
+        // Workers, e.g., of the learner, evaluate with the global net
+        nnueNet.reset();
       }
   }
 }
@@ -193,6 +243,32 @@ void ThreadPool::clear() {
   main()->previousTimeReduction = 1.0;
 }
 
+/// ThreadPool::memory_usage() adds the per-thread data to the memory report. The
+/// histories are part of the thread objects, the hash tables are allocated by
+/// each thread separately.
+
+void ThreadPool::memory_usage(std::vector<MemoryUsage>& usage) const {
+
+  if (empty())
+      return;
+
+  constexpr size_t HistoryBytes =  sizeof(Thread::counterMoves) + sizeof(Thread::mainHistory)
+                                 + sizeof(Thread::lowPlyHistory) + sizeof(Thread::captureHistory)
+                                 + sizeof(Thread::continuationHistory);
+  constexpr size_t TableBytes = Pawns::Table::Bytes + Material::Table::Bytes;
+
+  size_t stateBytes = 0, tableHugeBytes = 0;
+  for (Thread* th : *this)
+  {
+      stateBytes += (th == front() ? sizeof(MainThread) : sizeof(Thread)) - HistoryBytes;
+      tableHugeBytes += huge_page_bytes(th->tablesMem, TableBytes);
+  }
+
+  usage.push_back({ "Search histories", HistoryBytes * size(), 0, size() });
+  usage.push_back({ "Other thread state", stateBytes, 0, size() });
+  usage.push_back({ "Pawn and material tables", TableBytes * size(), tableHugeBytes, size() });
+}
+
 void ThreadPool::execute_with_workers(const std::function<void(Thread&)>& worker)
 {
   for(Thread* th : *this)
@@ -227,6 +303,10 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   if (states.get())
       setupStates = std::move(states); // Ownership transfer, states is now empty
 
+  // Pick up a net swapped in since the last search. Accumulators computed with
+  // another net are refreshed, since they store the id of their net.
+  std::shared_ptr<const Eval::NNUE::Net> net = Eval::NNUE::swapped_net();
+
   // We use Position::set() to set root position across threads. But there are
   // some StateInfo fields (previous, pliesFromNull, capturedPiece) that cannot
   // be deduced from a fen string, so set() clears them and they are set from
@@ -235,6 +315,8 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   for (Thread* th : *this)
   {
       th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = 0;
+      th->nodesLimit = uint64_t(limits.threadNodes);
+      th->nnueNet = net;
       th->rootDepth = th->completedDepth = 0;
       th->rootMoves = rootMoves;
       th->rootPos.set(pos.variant(), pos.fen(), pos.is_chess960(), &th->rootState, th);
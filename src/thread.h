@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -33,6 +34,8 @@
 #include "search.h"
 #include "thread_win32_osx.h"
 
+namespace Eval::NNUE { struct Net; }
+
 
 /// Thread class keeps together all the thread-related stuff. We use
 /// per-thread pawn and material hash tables so that once we get a
@@ -60,12 +63,17 @@ public:
   virtual void execute_with_worker(std::function<void(Thread&)> t);
 
   void clear();
+  void allocate_tables();
+  void clear_tables();
   void idle_loop();
   void start_searching();
   void wait_for_search_finished();
   void wait_for_worker_finished();
+  bool is_searching();
   size_t thread_idx() const { return idx; }
+  bool stopped() const;
 
+  void* tablesMem = nullptr;
   Pawns::Table pawnsTable;
   Material::Table materialTable;
   size_t pvIdx, pvLast;
@@ -73,6 +81,8 @@ public:
   int selDepth, nmpMinPly;
   Color nmpColor;
   std::atomic<uint64_t> nodes, tbHits, bestMoveChanges;
+  uint64_t nodesLimit = 0; // Node budget of this thread for the current search, 0 if none
+  std::shared_ptr<const Eval::NNUE::Net> nnueNet; // Swapped in net of the current search, if any
 
   Position rootPos;
   StateInfo rootState;
@@ -89,6 +99,7 @@ public:
   bool UseRule50;
   Depth ProbeDepth;
   int failedHighCnt;
+  Search::LearnerContext learner;
 };
 
 
@@ -125,6 +136,7 @@ struct ThreadPool : public std::vector<Thread*> {
   void start_thinking(Position&, StateListPtr&, const Search::LimitsType&, bool = false);
   void clear();
   void set(size_t);
+  void memory_usage(std::vector<MemoryUsage>& usage) const;
 
   MainThread* main()        const { return static_cast<MainThread*>(front()); }
   uint64_t nodes_searched() const { return accumulate(&Thread::nodes); }
@@ -151,4 +163,14 @@ private:
 
 extern ThreadPool Threads;
 
+
+/// Thread::stopped() returns true if the search has been stopped or if this
+/// thread has used up its own node budget. Only the counter of this thread
+/// is read, so the check is cheap enough to be done at every node.
+
+inline bool Thread::stopped() const {
+  return   Threads.stop.load(std::memory_order_relaxed)
+        || (nodesLimit && nodes.load(std::memory_order_relaxed) >= nodesLimit);
+}
+
 #endif // #ifndef THREAD_H_INCLUDED
@@ -153,6 +153,15 @@ TTEntry* TranspositionTable::probe(const Key key, bool& found) const {
 }
 
 
+/// TranspositionTable::memory_usage() adds the table to the memory report
+
+void TranspositionTable::memory_usage(std::vector<MemoryUsage>& usage) const {
+
+  const size_t bytes = clusterCount * sizeof(Cluster);
+  usage.push_back({ "Transposition table", bytes, huge_page_bytes(table, bytes) });
+}
+
+
 /// TranspositionTable::hashfull() returns an approximation of the hashtable
 /// occupation during a search. The hash is x permill full, as per UCI protocol.
 
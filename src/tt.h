@@ -77,6 +77,7 @@ public:
   void new_search() { generation8 += 8; } // Lower 3 bits are used by PV flag and Bound
   TTEntry* probe(const Key key, bool& found) const;
   int hashfull() const;
+  void memory_usage(std::vector<MemoryUsage>& usage) const;
   void resize(size_t mbSize);
   void clear();
 
@@ -175,6 +175,7 @@ public:
   static void init() { for (auto& e : instance().list) e->init_option(); read_options(); } // Deferred, due to UCI::Options access
   static void read_options() { for (auto& e : instance().list) e->read_option(); }
   static bool update_on_last;
+  static std::vector<std::pair<std::string, Range>> options; // Created UCI options, used by the tuner
 };
 
 // Some macro magic :-) we define a dummy int variable that compiler initializes calling Tune::add()
@@ -81,12 +81,15 @@
 #if defined(USE_PEXT)
 #  include <immintrin.h> // Header for _pext_u64() intrinsic
 #  ifdef LARGEBOARDS
-#    define pext(b, m) (_pext_u64(b, m) ^ (_pext_u64(b >> 64, m >> 64) << popcount((m << 64) >> 64)))
+     // Extract each half separately, the bits of the upper half follow the n bits of the lower half
+#    define pext_128(b, m, n) (_pext_u64(b, m) ^ (_pext_u64(b >> 64, m >> 64) << (n)))
+#    define pext(b, m) pext_128(b, m, popcount((m << 64) >> 64))
 #  else
 #    define pext(b, m) _pext_u64(b, m)
 #  endif
 #else
 #  define pext(b, m) 0
+#  define pext_128(b, m, n) 0
 #endif
 
 #ifdef USE_POPCNT
@@ -472,9 +475,6 @@ constexpr Value PieceValue[PHASE_NB][PIECE_NB] = {
 static_assert(   PieceValue[MG][PIECE_TYPE_NB + 1] == PawnValueMg
               && PieceValue[EG][PIECE_TYPE_NB + 1] == PawnValueEg, "PieceValue array broken");
 
-extern Value EvalPieceValue[PHASE_NB][PIECE_NB]; // variant piece values for evaluation
-extern Value CapturePieceValue[PHASE_NB][PIECE_NB]; // variant piece values for captures/search
-
 typedef int Depth;
 
 enum : int {
@@ -24,6 +24,7 @@
 
 #include "nnue/evaluate_nnue.h"
 #include "evaluate.h"
+#include "mate.h"
 #include "movegen.h"
 #include "nnue/nnue_test_command.h"
 #include "position.h"
@@ -38,10 +39,14 @@
 #include "learn/gensfen.h"
 #include "learn/learn.h"
 #include "learn/convert.h"
+#include "learn/tuner.h"
 
 using namespace std;
 
 extern vector<string> setup_bench(const Position&, istream&);
+extern void movegen_bench(istream&);
+extern void mate_bench(istream&);
+extern void multipv_bench(istream&);
 
 // FEN string of the initial position, normal chess
 const char* StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
@@ -59,6 +64,19 @@ void test_cmd(Position& pos, istringstream& is)
 
 namespace {
 
+  // The position set up by the last "position" command. During a game GUIs
+  // send the whole game with every command, so a command that only appends
+  // moves to the last one continues from its position.
+  struct {
+    const Variant* variant = nullptr;
+    string fen;
+    bool sfen, chess960;
+    vector<string> moves;
+    const std::deque<StateInfo>* states = nullptr;
+    const StateInfo* st = nullptr;
+    Key key;
+  } LastPosition;
+
   // position() is called when engine receives the "position" UCI command.
   // The function sets up the position described in the given FEN string ("fen")
   // or the starting position ("startpos") and then makes the moves given in the
@@ -84,15 +102,52 @@ namespace {
     else
         return;
 
-    states = StateListPtr(new std::deque<StateInfo>(1)); // Drop old and create a new one
-    pos.set(variants.find(Options["UCI_Variant"])->second, fen, Options["UCI_Chess960"], &states->back(), Threads.main(), sfen);
+    const Variant* v = variants.find(Options["UCI_Variant"])->second;
+    const bool chess960 = Options["UCI_Chess960"];
+    vector<string> moves;
+    while (is >> token)
+        moves.push_back(token);
+
+    // The states of the last position are owned by the thread pool after a
+    // "go", and can be taken back once the search has finished.
+    if (   !states.get()
+        && LastPosition.states
+        && Threads.setupStates.get() == LastPosition.states
+        && !Threads.main()->is_searching())
+        states = std::move(Threads.setupStates);
+
+    if (   v == LastPosition.variant
+        && fen == LastPosition.fen
+        && sfen == LastPosition.sfen
+        && chess960 == LastPosition.chess960
+        && LastPosition.moves.size() <= moves.size()
+        && std::equal(LastPosition.moves.begin(), LastPosition.moves.end(), moves.begin())
+        && states.get() == LastPosition.states
+        && pos.state() == LastPosition.st
+        && pos.key() == LastPosition.key)
+        moves.erase(moves.begin(), moves.begin() + LastPosition.moves.size());
+    else
+    {
+        states = StateListPtr(new std::deque<StateInfo>(1)); // Drop old and create a new one
+        pos.set(v, fen, chess960, &states->back(), Threads.main(), sfen);
+        LastPosition = { v, fen, sfen, chess960, {}, nullptr, nullptr, 0 };
+    }
 
     // Parse move list (if any)
-    while (is >> token && (m = UCI::to_move(pos, token)) != MOVE_NONE)
+    for (const string& move : moves)
     {
+        token = move;
+        if ((m = UCI::to_move(pos, token)) == MOVE_NONE)
+            break;
+
         states->emplace_back();
         pos.do_move(m, states->back());
+        LastPosition.moves.push_back(move);
     }
+
+    LastPosition.states = states.get();
+    LastPosition.st = pos.state();
+    LastPosition.key = pos.key();
   }
 
   // trace_eval() prints the evaluation for the current position, consistent with the UCI
@@ -160,6 +215,7 @@ namespace {
         else if (token == "movestogo") is >> limits.movestogo;
         else if (token == "depth")     is >> limits.depth;
         else if (token == "nodes")     is >> limits.nodes;
+        else if (token == "threadnodes") is >> limits.threadNodes;
         else if (token == "movetime")  is >> limits.movetime;
         else if (token == "mate")      is >> limits.mate;
         else if (token == "perft")     is >> limits.perft;
@@ -192,6 +248,25 @@ namespace {
     string token;
     uint64_t num, nodes = 0, cnt = 1;
 
+    streampos args0 = args.tellg();
+    if ((args >> token) && token == "movegen")
+    {
+        movegen_bench(args);
+        return;
+    }
+    if (token == "mate")
+    {
+        mate_bench(args);
+        return;
+    }
+    if (token == "multipv")
+    {
+        multipv_bench(args);
+        return;
+    }
+    args.clear();
+    args.seekg(args0);
+
     vector<string> list = setup_bench(pos, args);
     num = count_if(list.begin(), list.end(), [](string s) { return s.find("go ") == 0 || s.find("eval") == 0; });
 
@@ -290,6 +365,16 @@ double UCI::win_rate_model_double(double v, int ply) {
         variants.parse<true>(token);
   }
 
+  // memory() is called when engine receives the "memory" command.
+  // The function prints the memory used by each subsystem.
+
+  void memory() {
+
+    std::ostringstream ss;
+    print_memory_usage(ss, UCI::memory_usage());
+    sync_cout << ss.str() << sync_endl;
+  }
+
 
 // --------------------
 // Call qsearch(),search() directly for testing
@@ -326,6 +411,21 @@ void search_cmd(Position& pos, istringstream& is)
   cout << endl;
 }
 
+/// UCI::memory_usage() collects the memory used by the engine. The learner
+/// commands add their own buffers to it.
+
+std::vector<MemoryUsage> UCI::memory_usage() {
+
+  std::vector<MemoryUsage> usage;
+  TT.memory_usage(usage);
+  Eval::NNUE::memory_usage(usage);
+  Threads.memory_usage(usage);
+  Tablebases::memory_usage(usage);
+  Mate::memory_usage(usage);
+  return usage;
+}
+
+
 /// UCI::loop() waits for a command from stdin, parses it and calls the appropriate
 /// function. Also intercepts EOF from stdin to ensure gracefully exiting if the
 /// GUI dies unexpectedly. When called with some command line arguments, e.g. to
@@ -401,6 +501,9 @@ void UCI::loop(int argc, char* argv[]) {
       else if (token == "ucinewgame" || token == "usinewgame" || token == "uccinewgame") Search::clear();
       else if (token == "isready")    sync_cout << "readyok" << sync_endl;
 
+      // Load a net in the background for the following searches, safe during a search
+      else if (token == "swapnet" && is >> token) Eval::NNUE::swap_net(token);
+
       // Additional custom non-UCI commands, mainly for debugging.
       // Do not use these commands during a search!
       else if (token == "flip")     pos.flip();
@@ -408,12 +511,15 @@ void UCI::loop(int argc, char* argv[]) {
       else if (token == "d")        sync_cout << pos << sync_endl;
       else if (token == "eval")     trace_eval(pos);
       else if (token == "compiler") sync_cout << compiler_info() << sync_endl;
+      else if (token == "memory")   memory();
       else if (token == "load")     { load(is); argc = 1; } // continue reading stdin
       else if (token == "check")    check(is);
 
       else if (token == "gensfen") Learner::gen_sfen(pos, is);
       else if (token == "learn") Learner::learn(pos, is);
+      else if (token == "validate") Learner::validate(is);
       else if (token == "convert") Learner::convert(is);
+      else if (token == "tune") Learner::tune(pos, is);
 
       // Command to call qsearch(),search() directly for testing
       else if (token == "qsearch") qsearch_cmd(pos);
@@ -575,8 +681,22 @@ Move UCI::to_move(const Position& pos, string& str) {
           str[4] = char(tolower(str[4]));
   }
 
+  // Formatting all legal moves is slow, e.g., with the drops in shogi, so only
+  // moves whose origin or destination occurs in the string are formatted.
+  // Castling and gating moves print both squares or at least the origin, while
+  // passes may be printed without any square, e.g., as "@@@@" in xboard.
+  const bool drop = str.find_first_of("*@") != string::npos;
+  string names[SQUARE_NB];
+  auto in_str = [&](Square s) {
+      if (names[s].empty())
+          names[s] = UCI::square(pos, s);
+      return str.find(names[s]) != string::npos;
+  };
+
   for (const auto& m : MoveList<LEGAL>(pos))
-      if (str == UCI::move(pos, m) || (is_pass(m) && str == UCI::square(pos, from_sq(m)) + UCI::square(pos, to_sq(m))))
+      if (   (   is_pass(m)
+              || (type_of(m) == DROP ? drop && in_str(to_sq(m)) : in_str(from_sq(m)) || in_str(to_sq(m))))
+          && (str == UCI::move(pos, m) || (is_pass(m) && str == UCI::square(pos, from_sq(m)) + UCI::square(pos, to_sq(m)))))
           return m;
 
   return MOVE_NONE;
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "misc.h"
 #include "types.h"
 
 class Position;
@@ -83,6 +84,11 @@ int win_rate_model(Value v, int ply);
 double win_rate_model_double(double v, int ply);
 Move to_move(const Position& pos, std::string& str);
 void setoption(const std::string& name, const std::string& value);
+std::vector<MemoryUsage> memory_usage();
+
+/// OptionsVersion is increased whenever an option is set, so that settings
+/// derived from the options can be cached
+extern uint64_t OptionsVersion;
 
 } // namespace UCI
 
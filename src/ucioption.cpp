@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <ostream>
 #include <sstream>
 #include <iostream>
@@ -43,6 +44,8 @@ namespace PSQT {
 
 namespace UCI {
 
+uint64_t OptionsVersion = 1;
+
 // standard variants of XBoard/WinBoard
 std::set<string> standard_variants = {
     "normal", "nocastle", "fischerandom", "knightmate", "3check", "makruk", "shatranj",
@@ -56,6 +59,10 @@ void on_hash_size(const Option& o) { TT.resize(size_t(o)); }
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option& o) { Threads.set(size_t(o)); }
 void on_tb_path(const Option& o) { Tablebases::init(o); }
+void on_tb_rescan(const Option&) {
+    Threads.main()->wait_for_search_finished();
+    Tablebases::init(Options["SyzygyPath"], true);
+}
 
 void on_use_NNUE(const Option& ) { Eval::NNUE::init(); }
 void on_eval_file(const Option& ) { Eval::NNUE::init(); }
@@ -72,7 +79,6 @@ void on_variant_change(const Option &o) {
     Eval::NNUE::init();
 
     const Variant* v = variants.find(o)->second;
-    PSQT::init(v);
     // Do not send setup command for known variants
     if (standard_variants.find(o) != standard_variants.end())
         return;
@@ -139,13 +145,16 @@ void on_variant_change(const Option &o) {
         }
     }
     else
-        sync_cout << "info string variant " << (std::string)o
-                << " files " << v->maxFile + 1
-                << " ranks " << v->maxRank + 1
-                << " pocket " << pocketsize
-                << " template " << v->variantTemplate
-                << " startpos " << v->startFen
-                << sync_endl;
+    {
+        std::ostringstream ss;
+        ss << "info string variant " << (std::string)o
+           << " files " << v->maxFile + 1
+           << " ranks " << v->maxRank + 1
+           << " pocket " << pocketsize
+           << " template " << v->variantTemplate
+           << " startpos " << v->startFen;
+        Search::print(ss.str());
+    }
 }
 
 
@@ -186,6 +195,7 @@ void init(OptionsMap& o) {
   o["SyzygyProbeDepth"]      << Option(1, 1, 100);
   o["Syzygy50MoveRule"]      << Option(true);
   o["SyzygyProbeLimit"]      << Option(7, 0, 7);
+  o["SyzygyRescan"]          << Option(on_tb_rescan);
 #ifdef USE_NNUE
   o["Use NNUE"]              << Option("true", {"false", "true", "pure"}, on_use_NNUE);
 #else
@@ -207,6 +217,7 @@ void init(OptionsMap& o) {
   // Enable transposition table.
   o["EnableTranspositionTable"] << Option(true, on_enable_transposition_table);
   o["TsumeMode"]             << Option(false);
+  o["MateSolver"]            << Option(true);
   o["VariantPath"]           << Option("<empty>", on_variant_path);
 }
 
@@ -359,6 +370,8 @@ Option& Option::operator=(const string& v) {
   if (type != "button")
       currentValue = v;
 
+  ++OptionsVersion;
+
   if (on_change)
       on_change(*this);
 
@@ -370,7 +383,11 @@ void Option::set_combo(std::vector<std::string> newComboValues) {
 }
 
 void Option::set_default(std::string newDefault) {
+    // Spin values are clamped to the range of the option
+    if (type == "spin")
+        newDefault = std::to_string(std::clamp(std::strtol(newDefault.c_str(), nullptr, 10), long(min), long(max)));
     defaultValue = currentValue = newDefault;
+    ++OptionsVersion;
 }
 
 const std::string Option::get_type() const {
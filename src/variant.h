@@ -19,6 +19,7 @@
 #ifndef VARIANT_H_INCLUDED
 #define VARIANT_H_INCLUDED
 
+#include <algorithm>
 #include <set>
 #include <map>
 #include <vector>
@@ -27,6 +28,7 @@
 
 #include "types.h"
 #include "bitboard.h"
+#include "psqt.h"
 
 
 /// Variant struct stores information needed to determine the rules of a variant.
@@ -131,7 +133,14 @@ struct Variant {
   // Derived properties
   bool fastAttacks = true;
   bool fastAttacks2 = true;
+  bool cachedAttacks = false;
   PieceType nnueKing = KING;
+  // Insufficient material, see Position::has_insufficient_material()
+  bool insufficientMaterialRule = true;
+  bool insufficientMaterialDraw = true;
+  std::vector<PieceType> restrictedPieceTypes[COLOR_NB];
+  std::vector<PieceType> matingPieceTypes[COLOR_NB];
+  std::vector<PieceType> colorboundPieceTypes;
 
   void add_piece(PieceType pt, char c, char c2 = ' ') {
       pieceToChar[make_piece(WHITE, pt)] = toupper(c);
@@ -176,9 +185,90 @@ struct Variant {
                                 })
                     && !cambodianMoves
                     && !diagonalLines;
+      // Keep the attacks of each piece up to date on the board when they are
+      // expensive to compute, see Position::update_attacks()
+      cachedAttacks =   !fastAttacks && !fastAttacks2
+                     && !cambodianMoves
+                     && !diagonalLines
+                     && !pieceTypes.count(JANGGI_CANNON);
       nnueKing = extinctionPieceTypes.find(COMMONER) != extinctionPieceTypes.end() ? COMMONER : KING;
+      conclude_insufficient_material();
       return this;
   }
+
+  // Classify the piece types for the insufficient material detection: pieces
+  // that can not reach the enemy king, pieces that can mate on their own
+  // (or pawns promoting to them) and color-bound pieces.
+  void conclude_insufficient_material() {
+      insufficientMaterialRule =   !capturesToHand
+                                && extinctionValue == VALUE_NONE
+                                && !connectN;
+      insufficientMaterialDraw =   insufficientMaterialRule
+                                && pieceTypes.count(KING)
+                                && checkmateValue == -VALUE_MATE
+                                && stalemateValue == VALUE_DRAW
+                                && !stalematePieceCount
+                                && nFoldValue == VALUE_DRAW
+                                && !perpetualCheckIllegal
+                                && !moveRepetitionIllegal
+                                && !bikjangRule
+                                && !materialCounting;
+
+      // Piece types that may appear on the board
+      std::set<PieceType> types = pieceTypes;
+      types.insert(promotionPieceTypes.begin(), promotionPieceTypes.end());
+      for (PieceType pt : pieceTypes)
+          if (promotedPieceType[pt])
+              types.insert(promotedPieceType[pt]);
+
+      // Variants are concluded before Bitboards::init(), so no lookup tables
+      Bitboard board = 0;
+      for (Rank r = RANK_1; r <= maxRank; ++r)
+          for (File f = FILE_A; f <= maxFile; ++f)
+              board |= Bitboard(1) << make_square(f, r);
+      auto region = [&](Color c, PieceType pt) {
+          return mobilityRegion[c][pt] ? mobilityRegion[c][pt] & board : board;
+      };
+
+      const auto isMating = [](PieceType pt) {
+          for (PieceType mpt : { ROOK, QUEEN, ARCHBISHOP, CHANCELLOR, SILVER, GOLD, COMMONER, CENTAUR })
+              if (pt == mpt)
+                  return true;
+          return false;
+      };
+
+      for (Color c : { WHITE, BLACK })
+      {
+          restrictedPieceTypes[c].clear();
+          matingPieceTypes[c].clear();
+
+          for (PieceType pt : pieceTypes)
+              if (pt == KING || !(region(c, pt) & region(~c, KING)))
+                  restrictedPieceTypes[c].push_back(pt);
+
+          for (PieceType pt : types)
+              if (   isMating(pt)
+                  && std::find(restrictedPieceTypes[c].begin(), restrictedPieceTypes[c].end(), pt) == restrictedPieceTypes[c].end())
+                  matingPieceTypes[c].push_back(pt);
+
+          if (std::any_of(promotionPieceTypes.begin(), promotionPieceTypes.end(), isMating))
+              matingPieceTypes[c].push_back(PAWN);
+
+          if (flagPiece)
+              matingPieceTypes[c].push_back(flagPiece);
+      }
+
+      colorboundPieceTypes.clear();
+      for (PieceType pt : { BISHOP, FERS, FERS_ALFIL, ALFIL, ELEPHANT })
+          if (types.count(pt))
+              colorboundPieceTypes.push_back(pt);
+  }
+
+  // Piece-square tables and piece values, computed on first use
+  const PSQT::Tables& psqt() const { return psqtCache.get(this); }
+
+private:
+  PSQT::Cache psqtCache;
 };
 
 class VariantMap : public std::map<std::string, const Variant*> {
@@ -59,6 +59,19 @@ promotionPieceTypes = qh
 flagPiece = k
 whiteFlag = *8
 blackFlag = *1
+
+# Connect-n variant, won by aligning pieces instead of mating
+[tictactoe]
+maxRank = 3
+maxFile = 3
+immobile = p
+startFen = 3/3/3[PPPPPpppp] w - - 0 1
+pieceDrops = true
+doubleStep = false
+castling = false
+stalemateValue = draw
+immobilityIllegal = false
+connectN = 3
 """
 
 sf.load_variant_config(ini_text)
@@ -118,6 +131,17 @@ variant_positions = {
     "orda": {
         "k7/8/8/8/8/8/8/K7 w - - 0 1": (False, False),  # K vs K
     },
+    "3check": {
+        "k7/8/8/8/8/8/8/K7 w - - 3+3 0 1": (True, True),  # K vs K
+        "k7/n7/8/8/8/8/8/K7 w - - 3+3 0 1": (True, False),  # K vs KN
+        "k7/b7/8/8/8/8/8/K7 w - - 1+2 0 1": (True, False),  # K vs KB
+        "k7/8/8/8/8/8/8/KP6 w - - 3+3 0 1": (False, True),  # KP vs K
+    },
+    "tictactoe": {
+        "3/3/3[PPPPPpppp] w - - 0 1": (False, False),  # starting position
+        "P1p/1P1/p2[PPPpp] w - - 0 1": (False, False),  # pieces on board and in hand
+        "PpP/pPp/3[] w - - 0 1": (False, False),  # empty hands
+    },
 }
 
 
@@ -62,7 +62,72 @@ cat << EOF > xboard.exp
    expect eof
 EOF
 
-for exp in uci.exp ucci.exp usi.exp ucicyclone.exp xboard.exp
+cat << EOF > position.exp
+   spawn ./stockfish
+   send "uci\\n"
+   expect "uciok"
+   # extend, shrink and change the moves of the previous position command
+   send "position startpos moves e2e4\\n"
+   send "position startpos moves e2e4 e7e5\\n"
+   send "d\\n"
+   expect -ex "Fen: rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2"
+   send "position startpos moves e2e4\\n"
+   send "d\\n"
+   expect -ex "Fen: rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"
+   send "position startpos moves e2e4 c7c5\\n"
+   send "d\\n"
+   expect -ex "Fen: rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2"
+   # extend after a search
+   send "go depth 5\\n"
+   expect "bestmove"
+   send "position startpos moves e2e4 c7c5 g1f3\\n"
+   send "d\\n"
+   expect -ex "Fen: rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2"
+   # castling
+   send "position startpos moves e2e4 e7e5 g1f3 b8c6 f1c4 g8f6\\n"
+   send "position startpos moves e2e4 e7e5 g1f3 b8c6 f1c4 g8f6 e1g1\\n"
+   send "d\\n"
+   expect -ex "Fen: r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQ1RK1 b kq - 5 4"
+   send "position startpos moves e2e4 e7e5 g1f3 b8c6 f1c4 g8f6 e1g1 f8c5\\n"
+   send "d\\n"
+   expect -ex "Fen: r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQ1RK1 w kq - 6 5"
+   send "setoption name UCI_Chess960 value true\\n"
+   send "position fen r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1 moves e1h1\\n"
+   send "position fen r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1 moves e1h1 e8a8\\n"
+   send "d\\n"
+   expect -ex "Fen: 2kr3r/8/8/8/8/8/8/R4RK1 w - - 2 2"
+   send "setoption name UCI_Chess960 value false\\n"
+   # drops
+   send "setoption name UCI_Variant value crazyhouse\\n"
+   send "position startpos moves e2e4 d7d5 e4d5 d8d5 b1c3 d5a5\\n"
+   send "position startpos moves e2e4 d7d5 e4d5 d8d5 b1c3 d5a5 P@d5\\n"
+   send "d\\n"
+   expect -ex "Fen: rnb1kbnr/ppp1pppp/8/q2P4/8/2N5/PPPP1PPP/R1BQKBNR\[p\] b KQkq - 0 4"
+   send "position startpos moves e2e4 d7d5 e4d5 d8d5 b1c3 d5a5 P@d5 P@e4 c3e4\\n"
+   send "d\\n"
+   expect -ex "Fen: rnb1kbnr/ppp1pppp/8/q2P4/4N3/8/PPPP1PPP/R1BQKBNR\[P\] b KQkq - 0 5"
+   send "position startpos moves e2e4 d7d5 e4d5 d8d5 b1c3 d5a5 P@d5 P@e4\\n"
+   send "d\\n"
+   expect -ex "Fen: rnb1kbnr/ppp1pppp/8/q2P4/4p3/2N5/PPPP1PPP/R1BQKBNR\[\] w KQkq - 0 5"
+   send "quit\\n"
+   expect eof
+EOF
+
+cat << EOF > xboardpass.exp
+   spawn ./stockfish
+   send "xboard\\n"
+   send "protover 2\\n"
+   expect "feature done=1"
+   send "variant janggi\\n"
+   send "force\\n"
+   send "usermove @@@@\\n"
+   send "d\\n"
+   expect -ex "Fen: rnba1abnr/4k4/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/4K4/RNBA1ABNR b - - 1 1"
+   send "quit\\n"
+   expect eof
+EOF
+
+for exp in uci.exp ucci.exp usi.exp ucicyclone.exp xboard.exp position.exp xboardpass.exp
 do
   echo "Testing $exp"
   timeout 5 expect $exp > /dev/null